@@ -0,0 +1,5 @@
+-- Keyset pagination index for /api/history: matches ORDER BY "timestamp" DESC, "id" DESC and the
+-- ("timestamp", "id") cursor. Built CONCURRENTLY so device ingest keeps writing DeviceHistory
+-- while it builds; that cannot run inside a transaction, so it is the only statement here.
+CREATE INDEX CONCURRENTLY "DeviceHistory_deviceId_timestamp_id_idx"
+ON "DeviceHistory"("deviceId", "timestamp" DESC, "id" DESC);
@@ -0,0 +1,44 @@
+-- CreateEnum
+CREATE TYPE "ExperimentStatus" AS ENUM ('active', 'stopped');
+
+-- CreateTable
+CREATE TABLE "Experiment" (
+    "id" UUID PRIMARY KEY DEFAULT gen_random_uuid(),
+    "name" TEXT NOT NULL,
+    "status" "ExperimentStatus" NOT NULL DEFAULT 'active',
+    "cohorts" JSONB NOT NULL,
+    "createdAt" TIMESTAMPTZ NOT NULL DEFAULT NOW(),
+    "updatedAt" TIMESTAMPTZ NOT NULL DEFAULT NOW(),
+    "stoppedAt" TIMESTAMPTZ
+);
+
+-- At most one experiment may assign parameters to the fleet at a time
+CREATE UNIQUE INDEX "Experiment_single_active_idx" ON "Experiment"("status") WHERE "status" = 'active';
+
+CREATE TRIGGER experiment_set_updated
+BEFORE UPDATE ON "Experiment"
+FOR EACH ROW
+EXECUTE FUNCTION set_updated_at();
+
+-- CreateTable
+CREATE TABLE "DeviceMetricReport" (
+    "id" BIGSERIAL PRIMARY KEY,
+    "deviceId" TEXT NOT NULL,
+    "experimentId" UUID,
+    "cohort" TEXT NOT NULL,
+    "paramsVersion" TEXT NOT NULL,
+    "windowMs" INTEGER NOT NULL,
+    "samplesSent" INTEGER NOT NULL,
+    "samplesMissed" INTEGER NOT NULL,
+    "retries" INTEGER NOT NULL,
+    "payloadBytes" INTEGER NOT NULL,
+    "avgUplinkLatencyMs" DOUBLE PRECISION NOT NULL,
+    "maxUplinkLatencyMs" DOUBLE PRECISION NOT NULL,
+    "minFreeHeap" INTEGER NOT NULL,
+    "reportedAt" TIMESTAMPTZ NOT NULL DEFAULT NOW(),
+    CONSTRAINT "DeviceMetricReport_experimentId_fkey" FOREIGN KEY ("experimentId") REFERENCES "Experiment"("id") ON DELETE SET NULL
+);
+
+-- CreateIndex
+CREATE INDEX "DeviceMetricReport_experimentId_cohort_idx" ON "DeviceMetricReport"("experimentId", "cohort");
+CREATE INDEX "DeviceMetricReport_deviceId_reportedAt_idx" ON "DeviceMetricReport"("deviceId", "reportedAt");
@@ -0,0 +1,25 @@
+-- CreateTable
+CREATE TABLE "AlertRule" (
+    "id" UUID PRIMARY KEY DEFAULT gen_random_uuid(),
+    "name" TEXT NOT NULL,
+    "deviceId" TEXT,
+    "lantai" INTEGER,
+    "enabled" BOOLEAN NOT NULL DEFAULT TRUE,
+    "definition" JSONB NOT NULL,
+    "createdAt" TIMESTAMPTZ NOT NULL DEFAULT NOW(),
+    "updatedAt" TIMESTAMPTZ NOT NULL DEFAULT NOW(),
+    -- A rule targets one device, one floor, or (both NULL) every device
+    CONSTRAINT "AlertRule_scope_check" CHECK ("deviceId" IS NULL OR "lantai" IS NULL)
+);
+
+-- One rule per name within a scope; narrower scopes override wider ones by name
+CREATE UNIQUE INDEX "AlertRule_scope_name_idx" ON "AlertRule"("name", COALESCE("deviceId", ''), COALESCE("lantai", 0));
+
+-- CreateIndex
+CREATE INDEX "AlertRule_deviceId_idx" ON "AlertRule"("deviceId");
+CREATE INDEX "AlertRule_lantai_idx" ON "AlertRule"("lantai");
+
+CREATE TRIGGER alert_rule_set_updated
+BEFORE UPDATE ON "AlertRule"
+FOR EACH ROW
+EXECUTE FUNCTION set_updated_at();
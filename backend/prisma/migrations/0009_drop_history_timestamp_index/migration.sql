@@ -0,0 +1,3 @@
+-- DeviceHistory_deviceId_timestamp_id_idx (0006) has the same leading columns, so the old index
+-- only costs write amplification. Dropped CONCURRENTLY for the same reason it was built that way.
+DROP INDEX CONCURRENTLY IF EXISTS "DeviceHistory_deviceId_timestamp_idx";
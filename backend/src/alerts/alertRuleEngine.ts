@@ -0,0 +1,545 @@
+import type { Logger } from 'pino';
+import { z } from 'zod';
+
+import type {
+  AlertCondition,
+  AlertNumericField,
+  AlertRuleDefinition,
+  AlertRuleRecord,
+  AlertStatusField,
+  DeviceSensorConfig,
+  SensorKey
+} from '../repositories/types';
+
+/** Subset of the computed sensor snapshot that rules can read. */
+export interface AlertSample {
+  amonia: { ppm: number | null; score: number | null; status: string };
+  waterPuddle: { digital: number; status: string };
+  sabun: Record<'sabun1' | 'sabun2' | 'sabun3', { distance: number; status: string }>;
+  tisu: Record<'tisu1' | 'tisu2', { digital: number; status: string }>;
+}
+
+export type AlertRuleScope = 'device' | 'floor' | 'global';
+
+export interface AlertRuleState {
+  ruleId: string;
+  name: string;
+  scope: AlertRuleScope;
+  message: string;
+  firing: boolean;
+  pendingSince: number | null;
+  clearingSince: number | null;
+}
+
+/** A rule that is currently firing for a device, with the sensors its condition reads. */
+export interface FiringAlert {
+  ruleId: string;
+  name: string;
+  message: string;
+  sensors: SensorKey[];
+}
+
+type Reader<T> = (sample: AlertSample) => T;
+
+// Sensors report -1 (or null for ammonia) when a reading is missing; rules never fire on those.
+const NUMERIC_FIELDS: Record<AlertNumericField, { sensor: SensorKey; read: Reader<number | null> }> = {
+  'amonia.ppm': { sensor: 'amonia', read: sample => sample.amonia.ppm },
+  'amonia.score': { sensor: 'amonia', read: sample => sample.amonia.score },
+  'water.digital': { sensor: 'water', read: sample => sample.waterPuddle.digital },
+  'sabun1.distance': { sensor: 'sabun1', read: sample => sample.sabun.sabun1.distance },
+  'sabun2.distance': { sensor: 'sabun2', read: sample => sample.sabun.sabun2.distance },
+  'sabun3.distance': { sensor: 'sabun3', read: sample => sample.sabun.sabun3.distance },
+  'tisu1.digital': { sensor: 'tisu1', read: sample => sample.tisu.tisu1.digital },
+  'tisu2.digital': { sensor: 'tisu2', read: sample => sample.tisu.tisu2.digital }
+};
+
+const STATUS_FIELDS: Record<AlertStatusField, { sensor: SensorKey; read: Reader<string> }> = {
+  'amonia.status': { sensor: 'amonia', read: sample => sample.amonia.status },
+  'water.status': { sensor: 'water', read: sample => sample.waterPuddle.status },
+  'sabun1.status': { sensor: 'sabun1', read: sample => sample.sabun.sabun1.status },
+  'sabun2.status': { sensor: 'sabun2', read: sample => sample.sabun.sabun2.status },
+  'sabun3.status': { sensor: 'sabun3', read: sample => sample.sabun.sabun3.status },
+  'tisu1.status': { sensor: 'tisu1', read: sample => sample.tisu.tisu1.status },
+  'tisu2.status': { sensor: 'tisu2', read: sample => sample.tisu.tisu2.status }
+};
+
+const MAX_CONDITION_NODES = 64;
+const TIME_PATTERN = /^([01]\d|2[0-3]):[0-5]\d$/;
+
+const numericFieldSchema = z.enum(Object.keys(NUMERIC_FIELDS) as [AlertNumericField, ...AlertNumericField[]]);
+const statusFieldSchema = z.enum(Object.keys(STATUS_FIELDS) as [AlertStatusField, ...AlertStatusField[]]);
+
+export const alertConditionSchema: z.ZodType<AlertCondition> = z.lazy(() =>
+  z.union([
+    z
+      .object({
+        type: z.literal('threshold'),
+        field: numericFieldSchema,
+        op: z.enum(['gt', 'gte', 'lt', 'lte']),
+        value: z.number().finite(),
+        clearValue: z.number().finite().optional()
+      })
+      .strict()
+      .refine(
+        condition =>
+          condition.clearValue === undefined ||
+          (condition.op.startsWith('g') ? condition.clearValue <= condition.value : condition.clearValue >= condition.value),
+        { message: 'clearValue must lie on the non-alerting side of value.', path: ['clearValue'] }
+      ),
+    z
+      .object({
+        type: z.literal('status'),
+        field: statusFieldSchema,
+        equals: z.array(z.string().min(1).max(40)).min(1).max(8)
+      })
+      .strict(),
+    z
+      .object({
+        type: z.literal('timeOfDay'),
+        from: z.string().regex(TIME_PATTERN, 'from must be HH:MM.'),
+        to: z.string().regex(TIME_PATTERN, 'to must be HH:MM.'),
+        days: z.array(z.number().int().min(0).max(6)).min(1).max(7).optional()
+      })
+      .strict(),
+    z.object({ type: z.literal('all'), conditions: z.array(alertConditionSchema).min(1).max(16) }).strict(),
+    z.object({ type: z.literal('any'), conditions: z.array(alertConditionSchema).min(1).max(16) }).strict(),
+    z.object({ type: z.literal('not'), condition: alertConditionSchema }).strict()
+  ]) as z.ZodType<AlertCondition>
+);
+
+export const alertRuleDefinitionSchema: z.ZodType<AlertRuleDefinition, z.ZodTypeDef, unknown> = z
+  .object({
+    message: z.string().trim().min(1).max(200),
+    condition: alertConditionSchema,
+    forMs: z.number().int().min(0).max(24 * 60 * 60 * 1000).default(0),
+    clearForMs: z.number().int().min(0).max(24 * 60 * 60 * 1000).default(0)
+  })
+  .strict()
+  .refine(definition => countNodes(definition.condition) <= MAX_CONDITION_NODES, {
+    message: `Conditions are limited to ${MAX_CONDITION_NODES} nodes.`,
+    path: ['condition']
+  });
+
+/**
+ * Global defaults that reproduce the alerts the /data handler used to hard-code. A stored rule
+ * with the same name replaces one for its scope, so supervisors can retune or disable them.
+ */
+export const BUILTIN_ALERT_RULES: AlertRuleRecord[] = [
+  {
+    id: 'builtin:soap-empty',
+    name: 'soap-empty',
+    deviceId: null,
+    lantai: null,
+    enabled: true,
+    definition: {
+      message: 'SABUN HAMPIR HABIS',
+      condition: {
+        type: 'any',
+        conditions: (['sabun1.status', 'sabun2.status', 'sabun3.status'] as const).map(field => ({
+          type: 'status' as const,
+          field,
+          equals: ['Habis']
+        }))
+      },
+      // Ultrasonic readings flicker while someone is at the dispenser.
+      forMs: 5000,
+      clearForMs: 0
+    } satisfies AlertRuleDefinition,
+    createdAt: new Date(0),
+    updatedAt: new Date(0)
+  },
+  {
+    id: 'builtin:tissue-empty',
+    name: 'tissue-empty',
+    deviceId: null,
+    lantai: null,
+    enabled: true,
+    definition: {
+      message: 'TISU HAMPIR HABIS',
+      condition: {
+        type: 'any',
+        conditions: (['tisu1.status', 'tisu2.status'] as const).map(field => ({
+          type: 'status' as const,
+          field,
+          equals: ['Habis']
+        }))
+      },
+      forMs: 0,
+      clearForMs: 0
+    } satisfies AlertRuleDefinition,
+    createdAt: new Date(0),
+    updatedAt: new Date(0)
+  }
+];
+
+interface EvaluationContext {
+  sample: AlertSample;
+  sensorConfig: DeviceSensorConfig;
+  clock: () => { minuteOfDay: number; dayOfWeek: number };
+}
+
+// Hysteresis leaves keep one flag each in the per-device state array.
+type CompiledCondition = (context: EvaluationContext, latches: Uint8Array) => boolean;
+
+interface CompiledRule {
+  id: string;
+  revision: string;
+  name: string;
+  scope: AlertRuleScope;
+  deviceId: string | null;
+  lantai: number | null;
+  enabled: boolean;
+  message: string;
+  forMs: number;
+  clearForMs: number;
+  latchCount: number;
+  sensors: SensorKey[];
+  evaluate: CompiledCondition;
+}
+
+interface RuleRuntimeState {
+  revision: string;
+  latches: Uint8Array;
+  pendingSince: number | null;
+  clearingSince: number | null;
+  firing: boolean;
+}
+
+function countNodes(condition: AlertCondition): number {
+  switch (condition.type) {
+    case 'all':
+    case 'any':
+      return condition.conditions.reduce((total, child) => total + countNodes(child), 1);
+    case 'not':
+      return 1 + countNodes(condition.condition);
+    default:
+      return 1;
+  }
+}
+
+function parseMinutes(value: string): number {
+  const [hours, minutes] = value.split(':').map(Number);
+  return hours * 60 + minutes;
+}
+
+function compileCondition(
+  condition: AlertCondition,
+  allocateLatch: () => number,
+  sensors: Set<SensorKey>
+): CompiledCondition {
+  switch (condition.type) {
+    case 'threshold': {
+      const { sensor, read } = NUMERIC_FIELDS[condition.field];
+      sensors.add(sensor);
+      const { value } = condition;
+      const test: (reading: number, limit: number) => boolean =
+        condition.op === 'gt'
+          ? (reading, limit) => reading > limit
+          : condition.op === 'gte'
+            ? (reading, limit) => reading >= limit
+            : condition.op === 'lt'
+              ? (reading, limit) => reading < limit
+              : (reading, limit) => reading <= limit;
+      const isMissing = (reading: number | null): reading is null =>
+        reading === null || !Number.isFinite(reading) || (condition.field !== 'amonia.score' && reading === -1);
+
+      if (condition.clearValue === undefined) {
+        return ({ sample, sensorConfig }) => {
+          const reading = read(sample);
+          return sensorConfig[sensor] && !isMissing(reading) && test(reading, value);
+        };
+      }
+
+      // Once tripped the leaf stays true until the reading crosses clearValue, so a value hovering
+      // around the threshold does not toggle the alert on every sample.
+      const clearValue = condition.clearValue;
+      const latch = allocateLatch();
+      return ({ sample, sensorConfig }, latches) => {
+        const reading = read(sample);
+        if (!sensorConfig[sensor] || isMissing(reading)) {
+          latches[latch] = 0;
+          return false;
+        }
+        const active = latches[latch] === 1 ? test(reading, clearValue) : test(reading, value);
+        latches[latch] = active ? 1 : 0;
+        return active;
+      };
+    }
+    case 'status': {
+      const { sensor, read } = STATUS_FIELDS[condition.field];
+      sensors.add(sensor);
+      const expected = new Set(condition.equals);
+      return ({ sample, sensorConfig }) => sensorConfig[sensor] && expected.has(read(sample));
+    }
+    case 'timeOfDay': {
+      const from = parseMinutes(condition.from);
+      const to = parseMinutes(condition.to);
+      const days = condition.days ? new Set(condition.days) : null;
+      // from > to spans midnight, e.g. 22:00-06:00.
+      return ({ clock }) => {
+        const { minuteOfDay, dayOfWeek } = clock();
+        if (days && !days.has(dayOfWeek)) {
+          return false;
+        }
+        return from <= to ? minuteOfDay >= from && minuteOfDay < to : minuteOfDay >= from || minuteOfDay < to;
+      };
+    }
+    case 'all':
+    case 'any': {
+      const children = condition.conditions.map(child => compileCondition(child, allocateLatch, sensors));
+      const requireAll = condition.type === 'all';
+      // No short-circuiting: hysteresis leaves must observe every sample to keep their latch current.
+      return (context, latches) => {
+        let matched = 0;
+        for (const child of children) {
+          if (child(context, latches)) {
+            matched += 1;
+          }
+        }
+        return requireAll ? matched === children.length : matched > 0;
+      };
+    }
+    case 'not': {
+      const child = compileCondition(condition.condition, allocateLatch, sensors);
+      return (context, latches) => !child(context, latches);
+    }
+    default:
+      throw new Error(`Unsupported condition type ${(condition as { type: string }).type}`);
+  }
+}
+
+function ruleScope(record: Pick<AlertRuleRecord, 'deviceId' | 'lantai'>): AlertRuleScope {
+  if (record.deviceId) {
+    return 'device';
+  }
+  return record.lantai !== null ? 'floor' : 'global';
+}
+
+export function compileRule(record: AlertRuleRecord): CompiledRule {
+  const definition = alertRuleDefinitionSchema.parse(record.definition);
+  let latchCount = 0;
+  const sensors = new Set<SensorKey>();
+  const evaluate = compileCondition(definition.condition, () => latchCount++, sensors);
+
+  return {
+    id: record.id,
+    revision: `${record.id}:${record.updatedAt.getTime()}`,
+    name: record.name,
+    scope: ruleScope(record),
+    deviceId: record.deviceId,
+    lantai: record.lantai,
+    enabled: record.enabled,
+    message: definition.message,
+    forMs: definition.forMs,
+    clearForMs: definition.clearForMs,
+    latchCount,
+    sensors: Array.from(sensors),
+    evaluate
+  };
+}
+
+function toFiringAlert(rule: CompiledRule): FiringAlert {
+  return { ruleId: rule.id, name: rule.name, message: rule.message, sensors: rule.sensors };
+}
+
+const SCOPE_PRECEDENCE: Record<AlertRuleScope, number> = { global: 0, floor: 1, device: 2 };
+const WEEKDAYS = ['Sun', 'Mon', 'Tue', 'Wed', 'Thu', 'Fri', 'Sat'];
+
+/**
+ * Evaluates compiled alert rules against each incoming sample. Every (device, rule) pair keeps
+ * its own small state (duration timers and hysteresis latches), so a sample costs O(rules that
+ * apply to the device) and never needs history. Rule sets are resolved per device once and
+ * cached until the rules change.
+ */
+export class AlertRuleEngine {
+  private rules: CompiledRule[] = [];
+  private readonly ruleSets = new Map<string, CompiledRule[]>();
+  private readonly deviceState = new Map<string, Map<string, RuleRuntimeState>>();
+  private readonly clockFormat: Intl.DateTimeFormat;
+
+  constructor(
+    timeZone: string,
+    private readonly logger: Logger
+  ) {
+    this.clockFormat = new Intl.DateTimeFormat('en-US', {
+      timeZone,
+      hourCycle: 'h23',
+      hour: '2-digit',
+      minute: '2-digit',
+      weekday: 'short'
+    });
+    this.setRules([]);
+  }
+
+  /** Replaces the stored rules. Built-in defaults are always appended underneath them. */
+  setRules(records: AlertRuleRecord[]): void {
+    const compiled: CompiledRule[] = [];
+    [...BUILTIN_ALERT_RULES, ...records].forEach(record => {
+      try {
+        compiled.push(compileRule(record));
+      } catch (error) {
+        this.logger.warn({ err: error, ruleId: record.id, ruleName: record.name }, 'Skipping alert rule that does not compile');
+      }
+    });
+
+    this.rules = compiled;
+    this.ruleSets.clear();
+
+    // Keep timers and latches for rules whose definition did not change.
+    const liveRevisions = new Set(compiled.map(rule => rule.revision));
+    this.deviceState.forEach(states => {
+      states.forEach((state, ruleId) => {
+        if (!liveRevisions.has(state.revision)) {
+          states.delete(ruleId);
+        }
+      });
+    });
+  }
+
+  /** Returns every rule currently firing for the device, in rule order. */
+  evaluate(deviceID: string, lantai: number, sample: AlertSample, sensorConfig: DeviceSensorConfig, now: number): FiringAlert[] {
+    const rules = this.resolveRuleSet(deviceID, lantai);
+    if (rules.length === 0) {
+      return [];
+    }
+
+    let states = this.deviceState.get(deviceID);
+    if (!states) {
+      states = new Map();
+      this.deviceState.set(deviceID, states);
+    }
+
+    let clockValue: { minuteOfDay: number; dayOfWeek: number } | null = null;
+    const context: EvaluationContext = {
+      sample,
+      sensorConfig,
+      clock: () => (clockValue ??= this.readClock(now))
+    };
+
+    const firing: FiringAlert[] = [];
+    for (const rule of rules) {
+      let state = states.get(rule.id);
+      if (!state || state.revision !== rule.revision) {
+        state = {
+          revision: rule.revision,
+          latches: new Uint8Array(rule.latchCount),
+          pendingSince: null,
+          clearingSince: null,
+          firing: false
+        };
+        states.set(rule.id, state);
+      }
+
+      if (rule.evaluate(context, state.latches)) {
+        state.clearingSince = null;
+        if (!state.firing) {
+          state.pendingSince ??= now;
+          if (now - state.pendingSince >= rule.forMs) {
+            state.firing = true;
+            state.pendingSince = null;
+          }
+        }
+      } else {
+        state.pendingSince = null;
+        if (state.firing) {
+          state.clearingSince ??= now;
+          if (now - state.clearingSince >= rule.clearForMs) {
+            state.firing = false;
+            state.clearingSince = null;
+          }
+        }
+      }
+
+      if (state.firing) {
+        firing.push(toFiringAlert(rule));
+      }
+    }
+
+    return firing;
+  }
+
+  /** Rules left firing by the last evaluated sample, without evaluating anything. */
+  firing(deviceID: string, lantai: number): FiringAlert[] {
+    const states = this.deviceState.get(deviceID);
+    if (!states) {
+      return [];
+    }
+    return this.resolveRuleSet(deviceID, lantai)
+      .filter(rule => {
+        const state = states.get(rule.id);
+        return state !== undefined && state.revision === rule.revision && state.firing;
+      })
+      .map(toFiringAlert);
+  }
+
+  /** Effective rule set for a device together with its live state, for the API. */
+  describe(deviceID: string, lantai: number): AlertRuleState[] {
+    const states = this.deviceState.get(deviceID);
+    return this.resolveRuleSet(deviceID, lantai).map(rule => {
+      const state = states?.get(rule.id);
+      const current = state && state.revision === rule.revision ? state : null;
+      return {
+        ruleId: rule.id,
+        name: rule.name,
+        scope: rule.scope,
+        message: rule.message,
+        firing: current?.firing ?? false,
+        pendingSince: current?.pendingSince ?? null,
+        clearingSince: current?.clearingSince ?? null
+      };
+    });
+  }
+
+  hasDeviceState(deviceID: string): boolean {
+    return this.deviceState.has(deviceID) || this.ruleSets.has(deviceID);
+  }
+
+  forgetDevice(deviceID: string): void {
+    this.deviceState.delete(deviceID);
+    this.ruleSets.delete(deviceID);
+  }
+
+  private resolveRuleSet(deviceID: string, lantai: number): CompiledRule[] {
+    const cached = this.ruleSets.get(deviceID);
+    if (cached) {
+      return cached;
+    }
+
+    // The narrowest scope wins per rule name (stored rules beat built-ins at the same scope); a
+    // disabled rule still shadows wider ones.
+    const byName = new Map<string, CompiledRule>();
+    this.rules.forEach(rule => {
+      const applies =
+        rule.scope === 'global' ||
+        (rule.scope === 'floor' && rule.lantai === lantai) ||
+        (rule.scope === 'device' && rule.deviceId === deviceID);
+      if (!applies) {
+        return;
+      }
+      const existing = byName.get(rule.name);
+      if (!existing || SCOPE_PRECEDENCE[rule.scope] >= SCOPE_PRECEDENCE[existing.scope]) {
+        byName.set(rule.name, rule);
+      }
+    });
+
+    const ruleSet = this.rules.filter(rule => rule.enabled && byName.get(rule.name) === rule);
+    this.ruleSets.set(deviceID, ruleSet);
+    return ruleSet;
+  }
+
+  private readClock(now: number): { minuteOfDay: number; dayOfWeek: number } {
+    let hour = 0;
+    let minute = 0;
+    let dayOfWeek = 0;
+    this.clockFormat.formatToParts(new Date(now)).forEach(part => {
+      if (part.type === 'hour') {
+        hour = Number(part.value) % 24;
+      } else if (part.type === 'minute') {
+        minute = Number(part.value);
+      } else if (part.type === 'weekday') {
+        dayOfWeek = WEEKDAYS.indexOf(part.value);
+      }
+    });
+    return { minuteOfDay: hour * 60 + minute, dayOfWeek };
+  }
+}
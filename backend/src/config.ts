@@ -41,6 +41,31 @@ function parsePositiveInt(value: string | undefined, fallback: number): number {
   return parsed;
 }
 
+function parseRate(value: string | undefined, fallback: number): number {
+  if (!value) {
+    return fallback;
+  }
+
+  const parsed = Number.parseFloat(value);
+  if (!Number.isFinite(parsed) || parsed < 0 || parsed > 1) {
+    return fallback;
+  }
+  return parsed;
+}
+
+function parseTimeZone(value: string | undefined, fallback: string): string {
+  const candidate = value?.trim();
+  if (!candidate) {
+    return fallback;
+  }
+  try {
+    new Intl.DateTimeFormat('en-US', { timeZone: candidate });
+    return candidate;
+  } catch {
+    return fallback;
+  }
+}
+
 const environmentSpecificOrigins =
   normalizedEnv === 'production'
     ? parseList(process.env.CORS_ALLOWED_ORIGINS_PRODUCTION)
@@ -80,6 +105,25 @@ if (!authSecret) {
 
 const tokenExpiration = process.env.AUTH_TOKEN_EXPIRATION || '12h';
 
+export type TelegramUpdateMode = 'polling' | 'webhook' | 'off';
+
+const telegramUpdateModeSchema = z.enum(['polling', 'webhook', 'off']);
+
+function resolveTelegramUpdateMode(): TelegramUpdateMode {
+  const explicit = telegramUpdateModeSchema.safeParse(process.env.TELEGRAM_UPDATE_MODE?.trim().toLowerCase());
+  if (explicit.success) {
+    return explicit.data;
+  }
+  // TELEGRAM_POLLING=false predates the webhook receiver and meant "send only".
+  return process.env.TELEGRAM_POLLING === 'false' ? 'off' : 'polling';
+}
+
+const telegramUpdateMode = resolveTelegramUpdateMode();
+const telegramWebhookSecret = process.env.TELEGRAM_WEBHOOK_SECRET?.trim() || null;
+if (telegramUpdateMode === 'webhook' && normalizedEnv === 'production' && !telegramWebhookSecret) {
+  throw new Error('TELEGRAM_WEBHOOK_SECRET must be set when TELEGRAM_UPDATE_MODE=webhook in production.');
+}
+
 export interface AppConfig {
   environment: Environment;
   allowedOrigins: readonly string[];
@@ -94,6 +138,37 @@ export interface AppConfig {
     secret: string;
     tokenExpiration: string;
   };
+  ingestAccessLog: {
+    successSampleRate: number;
+    slowRequestMs: number;
+    summaryIntervalMs: number;
+  };
+  database: {
+    replicaUrl: string | null;
+    replicaMaxLagMs: number;
+    replicaLagCheckIntervalMs: number;
+  };
+  alerts: {
+    timeZone: string;
+  };
+  telegram: {
+    updateMode: TelegramUpdateMode;
+    apiBaseUrl: string | null;
+    webhookUrl: string | null;
+    webhookSecret: string | null;
+    updateBatchSize: number;
+    updateBatchIntervalMs: number;
+    maxQueuedUpdates: number;
+  };
+  eventLoopLag: {
+    windowMs: number;
+  };
+  deviceState: {
+    retentionMs: number;
+    maxDevices: number;
+    pendingAlertActionTtlMs: number;
+    sweepIntervalMs: number;
+  };
 }
 
 export const appConfig: AppConfig = {
@@ -109,6 +184,37 @@ export const appConfig: AppConfig = {
   auth: {
     secret: authSecret,
     tokenExpiration
+  },
+  ingestAccessLog: {
+    successSampleRate: parseRate(process.env.INGEST_LOG_SUCCESS_SAMPLE_RATE, 0.01),
+    slowRequestMs: parsePositiveInt(process.env.INGEST_LOG_SLOW_MS, 1000),
+    summaryIntervalMs: parsePositiveInt(process.env.INGEST_LOG_SUMMARY_INTERVAL_MS, 60_000)
+  },
+  database: {
+    replicaUrl: process.env.DATABASE_REPLICA_URL?.trim() || null,
+    replicaMaxLagMs: parsePositiveInt(process.env.DATABASE_REPLICA_MAX_LAG_MS, 5000),
+    replicaLagCheckIntervalMs: parsePositiveInt(process.env.DATABASE_REPLICA_LAG_CHECK_INTERVAL_MS, 5000)
+  },
+  alerts: {
+    timeZone: parseTimeZone(process.env.ALERT_RULE_TIME_ZONE, 'Asia/Jakarta')
+  },
+  telegram: {
+    updateMode: telegramUpdateMode,
+    apiBaseUrl: process.env.TELEGRAM_API_BASE_URL?.trim() || null,
+    webhookUrl: process.env.TELEGRAM_WEBHOOK_URL?.trim() || null,
+    webhookSecret: telegramWebhookSecret,
+    updateBatchSize: parsePositiveInt(process.env.TELEGRAM_UPDATE_BATCH_SIZE, 20),
+    updateBatchIntervalMs: parsePositiveInt(process.env.TELEGRAM_UPDATE_BATCH_INTERVAL_MS, 50),
+    maxQueuedUpdates: parsePositiveInt(process.env.TELEGRAM_MAX_QUEUED_UPDATES, 1000)
+  },
+  eventLoopLag: {
+    windowMs: parsePositiveInt(process.env.EVENT_LOOP_LAG_WINDOW_MS, 10_000)
+  },
+  deviceState: {
+    retentionMs: parsePositiveInt(process.env.DEVICE_STATE_RETENTION_MINUTES, 72 * 60) * 60_000,
+    maxDevices: parsePositiveInt(process.env.DEVICE_STATE_MAX_DEVICES, 5000),
+    pendingAlertActionTtlMs: parsePositiveInt(process.env.PENDING_ALERT_ACTION_TTL_HOURS, 24) * 3_600_000,
+    sweepIntervalMs: parsePositiveInt(process.env.DEVICE_STATE_SWEEP_INTERVAL_MS, 60_000)
   }
 };
 
@@ -0,0 +1,58 @@
+import cors from 'cors';
+import type { CorsOptions } from 'cors';
+import type { ErrorRequestHandler, RequestHandler } from 'express';
+
+export interface CorsPolicyOptions {
+  allowRequestsWithoutOrigin: boolean;
+  isAllowedOrigin: (origin: string) => boolean;
+  // Server-to-server endpoints that authenticate on their own and never see a browser Origin.
+  exemptPaths: string[];
+}
+
+const MISSING_ORIGIN_MESSAGE = 'Origin header is required.';
+
+/**
+ * Browser origin policy for the API. Outside development a request must carry an allowed Origin;
+ * exempt paths bypass the check entirely and get no CORS headers.
+ */
+export function createCorsMiddleware(options: CorsPolicyOptions): RequestHandler {
+  const corsOptions: CorsOptions = {
+    origin: (origin, callback) => {
+      if (!origin) {
+        if (options.allowRequestsWithoutOrigin) {
+          callback(null, true);
+        } else {
+          callback(new Error(MISSING_ORIGIN_MESSAGE));
+        }
+        return;
+      }
+
+      if (options.isAllowedOrigin(origin)) {
+        callback(null, true);
+        return;
+      }
+
+      callback(new Error(`Origin ${origin} is not allowed.`));
+    },
+    credentials: true
+  };
+
+  const exempt = new Set(options.exemptPaths);
+  const handler = cors(corsOptions);
+  return (req, res, next) => {
+    if (exempt.has(req.path)) {
+      next();
+      return;
+    }
+    handler(req, res, next);
+  };
+}
+
+/** Turns origin rejections raised by the CORS middleware into 403 responses. */
+export const corsErrorHandler: ErrorRequestHandler = (err: Error, _req, res, next) => {
+  if (err.message === MISSING_ORIGIN_MESSAGE || err.message.includes('is not allowed')) {
+    res.status(403).json({ error: err.message });
+    return;
+  }
+  next(err);
+};
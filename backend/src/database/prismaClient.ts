@@ -1,3 +1,10 @@
 import { PrismaClient } from '@prisma/client';
 
+import { appConfig } from '../config';
+
 export const prisma = new PrismaClient();
+
+// Separate client (and connection pool) for read-only queries; null when no replica is configured.
+export const replicaPrisma = appConfig.database.replicaUrl
+  ? new PrismaClient({ datasources: { db: { url: appConfig.database.replicaUrl } } })
+  : null;
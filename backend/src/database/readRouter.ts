@@ -0,0 +1,171 @@
+import type { PrismaClient } from '@prisma/client';
+import type { Logger } from 'pino';
+
+export interface ReadRouterOptions {
+  maxLagMs: number;
+  lagCheckIntervalMs: number;
+}
+
+export interface ReadRouterStatus {
+  replicaConfigured: boolean;
+  replicaHealthy: boolean;
+  replicaLagMs: number | null;
+  replicaBytesBehind: number | null;
+  walReceiverStatus: string | null;
+  lastCheckedAt: string | null;
+  lastError: string | null;
+  routedToReplica: number;
+  routedToPrimary: number;
+  fallbacks: number;
+}
+
+type LagRow = {
+  inRecovery: boolean;
+  receiverStatus: string;
+  bytesBehind: number | null;
+  replayAgeMs: number | null;
+};
+
+/**
+ * Chooses the client for read-only queries. Reads go to the replica while it is reachable and
+ * its replay lag is within maxLagMs; otherwise, and whenever a replica query fails, they run on
+ * the primary. Writes never go through here.
+ *
+ * Lag is measured against the primary's WAL position, not the standby's own receive position:
+ * a standby whose WAL receiver has stalled has replayed everything it received and would look
+ * caught up while its data gets arbitrarily stale.
+ */
+export class ReadRouter {
+  private replicaHealthy = false;
+  private replicaLagMs: number | null = null;
+  private replicaBytesBehind: number | null = null;
+  private walReceiverStatus: string | null = null;
+  private lastCheckedAt: Date | null = null;
+  private lastError: string | null = null;
+  private routedToReplica = 0;
+  private routedToPrimary = 0;
+  private fallbacks = 0;
+  private timer: NodeJS.Timeout | null = null;
+
+  constructor(
+    private readonly primary: PrismaClient,
+    private readonly replica: PrismaClient | null,
+    private readonly options: ReadRouterOptions,
+    private readonly logger: Logger
+  ) {}
+
+  start(): void {
+    if (!this.replica || this.timer) {
+      return;
+    }
+    void this.checkLag();
+    this.timer = setInterval(() => void this.checkLag(), this.options.lagCheckIntervalMs);
+    this.timer.unref();
+  }
+
+  stop(): void {
+    if (this.timer) {
+      clearInterval(this.timer);
+      this.timer = null;
+    }
+  }
+
+  async read<T>(query: (client: PrismaClient) => Promise<T>): Promise<T> {
+    if (!this.replica || !this.replicaHealthy) {
+      this.routedToPrimary += 1;
+      return query(this.primary);
+    }
+
+    try {
+      const result = await query(this.replica);
+      this.routedToReplica += 1;
+      return result;
+    } catch (error) {
+      // Reads are idempotent, so one retry on the primary is always safe. The replica stays out
+      // of rotation until the next lag check succeeds.
+      this.fallbacks += 1;
+      this.routedToPrimary += 1;
+      this.markUnhealthy(error);
+      return query(this.primary);
+    }
+  }
+
+  status(): ReadRouterStatus {
+    return {
+      replicaConfigured: Boolean(this.replica),
+      replicaHealthy: this.replicaHealthy,
+      replicaLagMs: this.replicaLagMs,
+      replicaBytesBehind: this.replicaBytesBehind,
+      walReceiverStatus: this.walReceiverStatus,
+      lastCheckedAt: this.lastCheckedAt ? this.lastCheckedAt.toISOString() : null,
+      lastError: this.lastError,
+      routedToReplica: this.routedToReplica,
+      routedToPrimary: this.routedToPrimary,
+      fallbacks: this.fallbacks
+    };
+  }
+
+  private async checkLag(): Promise<void> {
+    if (!this.replica) {
+      return;
+    }
+
+    try {
+      // The primary position is read first, so a standby that has replayed up to it was fully
+      // caught up at some point during this check, however idle the primary is.
+      const [primary] = await this.primary.$queryRaw<{ lsn: string }[]>`SELECT pg_current_wal_lsn()::text AS "lsn"`;
+      const [row] = await this.replica.$queryRaw<LagRow[]>`
+        SELECT pg_is_in_recovery() AS "inRecovery",
+               COALESCE((SELECT COALESCE(status, 'unknown') FROM pg_stat_wal_receiver), 'stopped') AS "receiverStatus",
+               GREATEST(pg_wal_lsn_diff(${primary.lsn}::pg_lsn, pg_last_wal_replay_lsn()), 0)::float8 AS "bytesBehind",
+               (EXTRACT(EPOCH FROM (now() - pg_last_xact_replay_timestamp())) * 1000)::float8 AS "replayAgeMs"
+      `;
+      this.lastCheckedAt = new Date();
+
+      if (!row || !row.inRecovery) {
+        // A promoted (or misconfigured) replica is a second writable database; keep reads on the
+        // primary so both never diverge from the dashboard's point of view.
+        this.setHealthy(false, null, 'Replica is not in recovery mode');
+        return;
+      }
+
+      this.replicaBytesBehind = row.bytesBehind;
+      this.walReceiverStatus = row.receiverStatus;
+
+      // 'stopped' means no WAL receiver is running at all. Its status reads as 'unknown' unless the
+      // replica role has pg_read_all_stats; the LSN comparison still catches a stall then.
+      if (row.receiverStatus !== 'unknown' && row.receiverStatus !== 'streaming') {
+        this.setHealthy(false, null, `WAL receiver is ${row.receiverStatus}`);
+        return;
+      }
+
+      const lagMs = row.bytesBehind === 0 ? 0 : row.replayAgeMs;
+      if (lagMs === null || lagMs > this.options.maxLagMs) {
+        this.setHealthy(false, lagMs, `Replica lag ${lagMs ?? 'unknown'}ms exceeds ${this.options.maxLagMs}ms`);
+        return;
+      }
+
+      this.setHealthy(true, lagMs, null);
+    } catch (error) {
+      this.lastCheckedAt = new Date();
+      this.markUnhealthy(error);
+    }
+  }
+
+  private markUnhealthy(error: unknown): void {
+    this.setHealthy(false, this.replicaLagMs, error instanceof Error ? error.message : String(error));
+  }
+
+  private setHealthy(healthy: boolean, lagMs: number | null, reason: string | null): void {
+    if (healthy !== this.replicaHealthy) {
+      if (healthy) {
+        this.logger.info({ lagMs }, 'Read replica back in rotation');
+      } else {
+        this.logger.warn({ lagMs, reason }, 'Read replica out of rotation, reading from primary');
+      }
+    }
+    this.replicaHealthy = healthy;
+    this.replicaLagMs = lagMs;
+    this.lastError = reason;
+  }
+}
@@ -0,0 +1,81 @@
+import type { DeviceSensorConfig, SensorKey } from './repositories/types';
+
+export const SENSOR_KEYS: SensorKey[] = ['amonia', 'water', 'sabun1', 'sabun2', 'sabun3', 'tisu1', 'tisu2'];
+export const DEFAULT_SENSOR_CONFIG: DeviceSensorConfig = {
+  amonia: true,
+  water: true,
+  sabun1: true,
+  sabun2: true,
+  sabun3: true,
+  tisu1: true,
+  tisu2: true
+};
+
+export function normalizeSensorConfig(config: Partial<DeviceSensorConfig>): DeviceSensorConfig {
+  const normalized: DeviceSensorConfig = { ...DEFAULT_SENSOR_CONFIG };
+  SENSOR_KEYS.forEach(key => {
+    const value = config[key];
+    normalized[key] = typeof value === 'boolean' ? value : DEFAULT_SENSOR_CONFIG[key];
+  });
+  return normalized;
+}
+
+export interface DeviceSensorSettingsSource {
+  get(deviceId: string): Promise<DeviceSensorConfig | null>;
+}
+
+/**
+ * Per-device sensor settings cached in front of the DeviceSettings table. Only the ingest path
+ * (get) and settings writes (set) populate the cache; read-only views use read, which falls back
+ * to the database without caching, so viewing an evicted device neither regrows the cache nor
+ * pins a default over the stored settings.
+ */
+export class DeviceSensorSettingsCache {
+  private readonly cache = new Map<string, DeviceSensorConfig>();
+
+  constructor(private readonly source: DeviceSensorSettingsSource) {}
+
+  async get(deviceId: string): Promise<DeviceSensorConfig> {
+    const cached = this.cache.get(deviceId);
+    if (cached) {
+      return cached;
+    }
+    const loaded = await this.load(deviceId);
+    this.cache.set(deviceId, loaded);
+    return loaded;
+  }
+
+  async read(deviceId: string): Promise<DeviceSensorConfig> {
+    return this.cache.get(deviceId) ?? this.load(deviceId);
+  }
+
+  peek(deviceId: string): DeviceSensorConfig | undefined {
+    return this.cache.get(deviceId);
+  }
+
+  set(deviceId: string, config: Partial<DeviceSensorConfig>): DeviceSensorConfig {
+    const normalized = normalizeSensorConfig(config);
+    this.cache.set(deviceId, normalized);
+    return normalized;
+  }
+
+  has(deviceId: string): boolean {
+    return this.cache.has(deviceId);
+  }
+
+  delete(deviceId: string): void {
+    this.cache.delete(deviceId);
+  }
+
+  keys(): IterableIterator<string> {
+    return this.cache.keys();
+  }
+
+  get size(): number {
+    return this.cache.size;
+  }
+
+  private async load(deviceId: string): Promise<DeviceSensorConfig> {
+    return normalizeSensorConfig((await this.source.get(deviceId)) ?? DEFAULT_SENSOR_CONFIG);
+  }
+}
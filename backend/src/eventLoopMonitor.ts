@@ -0,0 +1,70 @@
+import { monitorEventLoopDelay } from 'node:perf_hooks';
+import type { IntervalHistogram } from 'node:perf_hooks';
+import type { Logger } from 'pino';
+
+export interface EventLoopLagWindow {
+  windowStart: string;
+  windowMs: number;
+  meanMs: number;
+  p50Ms: number;
+  p99Ms: number;
+  maxMs: number;
+}
+
+const RESOLUTION_MS = 10;
+
+const toMs = (nanoseconds: number): number => Number((nanoseconds / 1e6).toFixed(3));
+
+/**
+ * Samples event-loop delay in fixed windows. Each completed window is logged once and kept as
+ * lastWindow, so a load run can poll /readyz and collect every window it overlapped.
+ */
+export class EventLoopMonitor {
+  private readonly histogram: IntervalHistogram = monitorEventLoopDelay({ resolution: RESOLUTION_MS });
+  private windowStartedAt = Date.now();
+  private lastWindow: EventLoopLagWindow | null = null;
+  private timer: NodeJS.Timeout | null = null;
+
+  constructor(
+    private readonly windowMs: number,
+    private readonly logger: Logger,
+    private readonly context: () => Record<string, unknown> = () => ({})
+  ) {}
+
+  start(): void {
+    if (this.timer) {
+      return;
+    }
+    this.histogram.enable();
+    this.windowStartedAt = Date.now();
+    this.timer = setInterval(() => this.rotate(), this.windowMs);
+    this.timer.unref();
+  }
+
+  stop(): void {
+    if (this.timer) {
+      clearInterval(this.timer);
+      this.timer = null;
+    }
+    this.histogram.disable();
+  }
+
+  status(): { lastWindow: EventLoopLagWindow | null } {
+    return { lastWindow: this.lastWindow };
+  }
+
+  private rotate(): void {
+    const now = Date.now();
+    this.lastWindow = {
+      windowStart: new Date(this.windowStartedAt).toISOString(),
+      windowMs: now - this.windowStartedAt,
+      meanMs: toMs(this.histogram.mean),
+      p50Ms: toMs(this.histogram.percentile(50)),
+      p99Ms: toMs(this.histogram.percentile(99)),
+      maxMs: toMs(this.histogram.max)
+    };
+    this.histogram.reset();
+    this.windowStartedAt = now;
+    this.logger.info({ ...this.lastWindow, ...this.context() }, 'Event loop lag summary');
+  }
+}
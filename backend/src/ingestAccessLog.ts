@@ -0,0 +1,135 @@
+import type { Request, RequestHandler, Response } from 'express';
+import type { Logger } from 'pino';
+
+export interface IngestAccessLogOptions {
+  successSampleRate: number;
+  slowRequestMs: number;
+  summaryIntervalMs: number;
+}
+
+interface DeviceIngestCounters {
+  success: number;
+  rejected: number;
+  error: number;
+  totalLatencyMs: number;
+  maxLatencyMs: number;
+}
+
+interface IngestRequestState {
+  startedAt: bigint;
+  latencyMs?: number;
+}
+
+const INGEST_PATH = '/data';
+const UNKNOWN_DEVICE = 'unknown';
+
+/**
+ * Replaces one access-log line per device sample with per-device counters that are flushed as
+ * a single summary line. Errors, rejections and slow requests on /data are still logged
+ * individually, plus a configurable sample of successes.
+ */
+export class IngestAccessLog {
+  private counters = new Map<string, DeviceIngestCounters>();
+  private windowStartedAt = Date.now();
+  private readonly flushTimer: NodeJS.Timeout;
+
+  constructor(
+    private readonly options: IngestAccessLogOptions,
+    private readonly logger: Logger
+  ) {
+    this.flushTimer = setInterval(() => this.flush(), options.summaryIntervalMs);
+    this.flushTimer.unref();
+  }
+
+  readonly middleware: RequestHandler = (req, res, next) => {
+    if (!isIngestRequest(req)) {
+      next();
+      return;
+    }
+
+    const state: IngestRequestState = { startedAt: process.hrtime.bigint() };
+    res.locals.ingestAccess = state;
+    res.once('finish', () => {
+      const latencyMs = getLatencyMs(state);
+      this.record(res.locals.deviceId ?? UNKNOWN_DEVICE, res.statusCode, latencyMs);
+    });
+    next();
+  };
+
+  /** Returns false for /data successes that are fast and not selected by the sample rate. */
+  shouldLog(req: Request, res: Response, err?: Error): boolean {
+    if (!isIngestRequest(req) || err || res.statusCode >= 400) {
+      return true;
+    }
+
+    const state = res.locals.ingestAccess as IngestRequestState | undefined;
+    if (state && getLatencyMs(state) >= this.options.slowRequestMs) {
+      return true;
+    }
+
+    return Math.random() < this.options.successSampleRate;
+  }
+
+  flush(): void {
+    const now = Date.now();
+    if (this.counters.size === 0) {
+      this.windowStartedAt = now;
+      return;
+    }
+
+    const devices: Record<string, DeviceIngestCounters & { avgLatencyMs: number }> = {};
+    let requests = 0;
+    this.counters.forEach((counters, deviceId) => {
+      const total = counters.success + counters.rejected + counters.error;
+      requests += total;
+      devices[deviceId] = {
+        ...counters,
+        totalLatencyMs: Number(counters.totalLatencyMs.toFixed(3)),
+        maxLatencyMs: Number(counters.maxLatencyMs.toFixed(3)),
+        avgLatencyMs: Number((counters.totalLatencyMs / total).toFixed(3))
+      };
+    });
+
+    this.logger.info(
+      { windowStart: new Date(this.windowStartedAt).toISOString(), windowMs: now - this.windowStartedAt, requests, devices },
+      'Ingest access summary'
+    );
+
+    this.counters = new Map();
+    this.windowStartedAt = now;
+  }
+
+  stop(): void {
+    clearInterval(this.flushTimer);
+    this.flush();
+  }
+
+  private record(deviceId: string, statusCode: number, latencyMs: number): void {
+    let counters = this.counters.get(deviceId);
+    if (!counters) {
+      counters = { success: 0, rejected: 0, error: 0, totalLatencyMs: 0, maxLatencyMs: 0 };
+      this.counters.set(deviceId, counters);
+    }
+
+    if (statusCode >= 500) {
+      counters.error += 1;
+    } else if (statusCode >= 400) {
+      counters.rejected += 1;
+    } else {
+      counters.success += 1;
+    }
+    counters.totalLatencyMs += latencyMs;
+    counters.maxLatencyMs = Math.max(counters.maxLatencyMs, latencyMs);
+  }
+}
+
+function isIngestRequest(req: Request): boolean {
+  return req.method === 'POST' && (req.originalUrl ?? req.url).split('?')[0] === INGEST_PATH;
+}
+
+function getLatencyMs(state: IngestRequestState): number {
+  if (state.latencyMs === undefined) {
+    state.latencyMs = Number(process.hrtime.bigint() - state.startedAt) / 1e6;
+  }
+  return state.latencyMs;
+}
@@ -0,0 +1,57 @@
+import { Prisma, PrismaClient } from '@prisma/client';
+
+import { AlertRuleInput, AlertRuleRecord } from './types';
+
+type AlertRuleRow = {
+  id: string;
+  name: string;
+  deviceId: string | null;
+  lantai: number | null;
+  enabled: boolean;
+  definition: Prisma.JsonValue;
+  createdAt: Date;
+  updatedAt: Date;
+};
+
+// The definition is validated by the rule compiler, which skips rules it cannot compile.
+const mapRowToRule = (row: AlertRuleRow): AlertRuleRecord => ({
+  id: row.id,
+  name: row.name,
+  deviceId: row.deviceId,
+  lantai: row.lantai,
+  enabled: row.enabled,
+  definition: row.definition,
+  createdAt: row.createdAt,
+  updatedAt: row.updatedAt
+});
+
+const toData = (input: AlertRuleInput) => ({
+  name: input.name,
+  deviceId: input.deviceId,
+  lantai: input.lantai,
+  enabled: input.enabled,
+  definition: input.definition as unknown as Prisma.JsonObject
+});
+
+export class AlertRuleRepository {
+  constructor(private readonly prisma: PrismaClient) {}
+
+  async list(): Promise<AlertRuleRecord[]> {
+    const rows = await this.prisma.alertRule.findMany({ orderBy: { createdAt: 'asc' } });
+    return rows.map(mapRowToRule);
+  }
+
+  async create(input: AlertRuleInput): Promise<AlertRuleRecord> {
+    const row = await this.prisma.alertRule.create({ data: toData(input) });
+    return mapRowToRule(row);
+  }
+
+  async update(id: string, input: AlertRuleInput): Promise<AlertRuleRecord> {
+    const row = await this.prisma.alertRule.update({ where: { id }, data: toData(input) });
+    return mapRowToRule(row);
+  }
+
+  async delete(id: string): Promise<void> {
+    await this.prisma.alertRule.delete({ where: { id } });
+  }
+}
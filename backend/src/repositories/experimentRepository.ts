@@ -0,0 +1,132 @@
+import { Prisma, PrismaClient } from '@prisma/client';
+
+import { CohortMetricSummary, DeviceMetricReportRecord, ExperimentCohort, ExperimentRecord } from './types';
+
+type ExperimentRow = {
+  id: string;
+  name: string;
+  status: ExperimentRecord['status'];
+  cohorts: Prisma.JsonValue;
+  createdAt: Date;
+  stoppedAt: Date | null;
+};
+
+const parseCohorts = (value: Prisma.JsonValue): ExperimentCohort[] => {
+  if (!Array.isArray(value)) {
+    return [];
+  }
+
+  return value.flatMap(entry => {
+    if (typeof entry !== 'object' || entry === null || Array.isArray(entry)) {
+      return [];
+    }
+    const raw = entry as Record<string, unknown>;
+    if (typeof raw.name !== 'string' || typeof raw.weight !== 'number') {
+      return [];
+    }
+    const parameters =
+      typeof raw.parameters === 'object' && raw.parameters !== null && !Array.isArray(raw.parameters)
+        ? (raw.parameters as ExperimentCohort['parameters'])
+        : {};
+    return [{ name: raw.name, weight: raw.weight, parameters }];
+  });
+};
+
+const mapRowToExperiment = (row: ExperimentRow): ExperimentRecord => ({
+  id: row.id,
+  name: row.name,
+  status: row.status,
+  cohorts: parseCohorts(row.cohorts),
+  createdAt: row.createdAt,
+  stoppedAt: row.stoppedAt
+});
+
+const toRatio = (numerator: number, denominator: number): number | null =>
+  denominator > 0 ? Number((numerator / denominator).toFixed(4)) : null;
+
+export class ExperimentRepository {
+  constructor(private readonly prisma: PrismaClient) {}
+
+  async findActive(): Promise<ExperimentRecord | null> {
+    const row = await this.prisma.experiment.findFirst({ where: { status: 'active' } });
+    return row ? mapRowToExperiment(row) : null;
+  }
+
+  async list(): Promise<ExperimentRecord[]> {
+    const rows = await this.prisma.experiment.findMany({ orderBy: { createdAt: 'desc' } });
+    return rows.map(mapRowToExperiment);
+  }
+
+  async findById(id: string): Promise<ExperimentRecord | null> {
+    const row = await this.prisma.experiment.findUnique({ where: { id } });
+    return row ? mapRowToExperiment(row) : null;
+  }
+
+  async create(name: string, cohorts: ExperimentCohort[]): Promise<ExperimentRecord> {
+    const serializedCohorts = cohorts.map(cohort => ({
+      name: cohort.name,
+      weight: cohort.weight,
+      parameters: { ...cohort.parameters }
+    })) as Prisma.JsonArray;
+
+    const row = await this.prisma.experiment.create({
+      data: { name, cohorts: serializedCohorts }
+    });
+    return mapRowToExperiment(row);
+  }
+
+  async stop(id: string): Promise<ExperimentRecord> {
+    const row = await this.prisma.experiment.update({
+      where: { id },
+      data: { status: 'stopped', stoppedAt: new Date() }
+    });
+    return mapRowToExperiment(row);
+  }
+
+  async recordMetrics(report: DeviceMetricReportRecord): Promise<void> {
+    await this.prisma.deviceMetricReport.create({ data: report });
+  }
+
+  async summarizeCohorts(experimentId: string): Promise<CohortMetricSummary[]> {
+    const groups = await this.prisma.deviceMetricReport.groupBy({
+      by: ['cohort'] as const,
+      where: { experimentId },
+      _count: { _all: true },
+      _sum: { samplesSent: true, samplesMissed: true, retries: true, payloadBytes: true },
+      _max: { maxUplinkLatencyMs: true },
+      _min: { minFreeHeap: true }
+    });
+
+    // Latency is weighted by samples so chatty devices are not under-represented.
+    const latencyRows = await this.prisma.$queryRaw<Array<{ cohort: string; weightedLatency: number | null; devices: bigint }>>`
+      SELECT "cohort",
+             SUM("avgUplinkLatencyMs" * "samplesSent") / NULLIF(SUM("samplesSent"), 0) AS "weightedLatency",
+             COUNT(DISTINCT "deviceId") AS "devices"
+      FROM "DeviceMetricReport"
+      WHERE "experimentId" = ${experimentId}::uuid
+      GROUP BY "cohort"
+    `;
+    const latencyByCohort = new Map(latencyRows.map(row => [row.cohort, row]));
+
+    return groups.map(group => {
+      const samplesSent = group._sum.samplesSent ?? 0;
+      const samplesMissed = group._sum.samplesMissed ?? 0;
+      const latency = latencyByCohort.get(group.cohort);
+      const weightedLatency = latency?.weightedLatency;
+
+      return {
+        cohort: group.cohort,
+        reports: group._count._all,
+        devices: Number(latency?.devices ?? 0),
+        samplesSent,
+        samplesMissed,
+        missRate: toRatio(samplesMissed, samplesSent + samplesMissed),
+        retriesPerSample: toRatio(group._sum.retries ?? 0, samplesSent),
+        bytesPerSample: toRatio(group._sum.payloadBytes ?? 0, samplesSent),
+        avgUplinkLatencyMs: typeof weightedLatency === 'number' ? Number(weightedLatency.toFixed(3)) : null,
+        maxUplinkLatencyMs: group._max.maxUplinkLatencyMs ?? null,
+        minFreeHeap: group._min.minFreeHeap ?? null
+      };
+    });
+  }
+}
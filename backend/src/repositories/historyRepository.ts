@@ -1,5 +1,6 @@
 import { Prisma, PrismaClient } from '@prisma/client';
 
+import type { ReadRouter } from '../database/readRouter';
 import { SnapshotRecord } from './types';
 
 const defaultString = (value: string | null): string => value ?? '';
@@ -17,6 +18,36 @@ type HistoryRow = {
   lastActive: Date;
 };
 
+type PaginatedHistoryRow = HistoryRow & {
+  cursorMicros: bigint;
+};
+
+/**
+ * Keyset position in a device's history. The timestamp is kept as integer microseconds since the
+ * epoch so the cursor round-trips exactly and does not depend on the session's DateStyle/TimeZone.
+ */
+export interface HistoryCursor {
+  timestampMicros: bigint;
+  id: bigint;
+}
+
+const CURSOR_SEPARATOR = '|';
+const INTEGER_PATTERN = /^-?\d+$/;
+
+export function encodeHistoryCursor(cursor: HistoryCursor): string {
+  return Buffer.from(`${cursor.timestampMicros.toString()}${CURSOR_SEPARATOR}${cursor.id.toString()}`, 'utf8').toString(
+    'base64url'
+  );
+}
+
+export function decodeHistoryCursor(value: string): HistoryCursor | null {
+  const [timestampMicros, id, ...rest] = Buffer.from(value, 'base64url').toString('utf8').split(CURSOR_SEPARATOR);
+  if (rest.length > 0 || !INTEGER_PATTERN.test(timestampMicros ?? '') || !INTEGER_PATTERN.test(id ?? '')) {
+    return null;
+  }
+  return { timestampMicros: BigInt(timestampMicros), id: BigInt(id) };
+}
+
 const mapRowToSnapshot = (row: HistoryRow): SnapshotRecord => ({
   deviceId: row.deviceId,
   displayName: row.displayName,
@@ -29,8 +60,15 @@ const mapRowToSnapshot = (row: HistoryRow): SnapshotRecord => ({
   lastActive: row.lastActive
 });
 
+/**
+ * Writes go to the primary; dashboard and export reads go through the ReadRouter so they can be
+ * served by a replica without competing with device ingest.
+ */
 export class HistoryRepository {
-  constructor(private readonly prisma: PrismaClient) {}
+  constructor(
+    private readonly prisma: PrismaClient,
+    private readonly reads: ReadRouter
+  ) {}
 
   async record(snapshot: SnapshotRecord): Promise<void> {
     const data: Prisma.DeviceHistoryUncheckedCreateInput = {
@@ -49,60 +87,57 @@ export class HistoryRepository {
   }
 
   async findByDevice(deviceId: string): Promise<SnapshotRecord[]> {
-    const rows = await this.prisma.deviceHistory.findMany({
-      where: { deviceId },
-      orderBy: { timestamp: 'asc' },
-      select: {
-        id: true,
-        deviceId: true,
-        displayName: true,
-        amonia: true,
-        waterPuddleJson: true,
-        sabun: true,
-        tisu: true,
-        timestamp: true,
-        espStatus: true,
-        lastActive: true
-      }
-    });
+    const rows = await this.reads.read(client =>
+      client.deviceHistory.findMany({
+        where: { deviceId },
+        orderBy: { timestamp: 'asc' },
+        select: {
+          id: true,
+          deviceId: true,
+          displayName: true,
+          amonia: true,
+          waterPuddleJson: true,
+          sabun: true,
+          tisu: true,
+          timestamp: true,
+          espStatus: true,
+          lastActive: true
+        }
+      })
+    );
     return rows.map(mapRowToSnapshot);
   }
 
   async findPaginatedByDevice(
     deviceId: string,
     limit: number,
-    cursor?: bigint
-  ): Promise<{ entries: SnapshotRecord[]; nextCursor: bigint | null }> {
-    const rows = await this.prisma.deviceHistory.findMany({
-      where: {
-        deviceId,
-        ...(cursor ? { id: { lt: cursor } } : {})
-      },
-      orderBy: [
-        { timestamp: 'desc' },
-        { id: 'desc' }
-      ],
-      take: limit,
-      select: {
-        id: true,
-        deviceId: true,
-        displayName: true,
-        amonia: true,
-        waterPuddleJson: true,
-        sabun: true,
-        tisu: true,
-        timestamp: true,
-        espStatus: true,
-        lastActive: true
-      }
-    });
+    cursor?: HistoryCursor
+  ): Promise<{ entries: SnapshotRecord[]; nextCursor: HistoryCursor | null }> {
+    // Row-value comparison keeps every page a single range scan on
+    // DeviceHistory_deviceId_timestamp_id_idx. Interval arithmetic keeps the microseconds exact.
+    const cursorCondition = cursor
+      ? Prisma.sql`AND ("timestamp", "id") < ('epoch'::timestamptz + ${cursor.timestampMicros} * INTERVAL '1 microsecond', ${cursor.id})`
+      : Prisma.empty;
+
+    const rows = await this.reads.read(
+      client => client.$queryRaw<PaginatedHistoryRow[]>`
+        SELECT "id", "deviceId", "displayName", "amonia", "waterPuddleJson", "sabun", "tisu",
+               "timestamp", "espStatus", "lastActive", (EXTRACT(EPOCH FROM "timestamp") * 1000000)::bigint AS "cursorMicros"
+        FROM "DeviceHistory"
+        WHERE "deviceId" = ${deviceId} ${cursorCondition}
+        ORDER BY "timestamp" DESC, "id" DESC
+        LIMIT ${limit}
+      `
+    );
 
     const entries = rows.map(mapRowToSnapshot);
-    const nextCursor = rows.length === limit ? rows[rows.length - 1].id : null;
+    const lastRow = rows[rows.length - 1];
+    const nextCursor = rows.length === limit ? { timestampMicros: lastRow.cursorMicros, id: lastRow.id } : null;
 
     return { entries, nextCursor };
   }
 
+  // Primary only: seeds the ingest save throttle, which must not see a lagging view.
   async getLatestTimestamps(): Promise<Record<string, Date>> {
     const rows = await this.prisma.deviceHistory.groupBy({
       by: ['deviceId'] as const,
@@ -25,3 +25,110 @@ export interface SubscriberRecord {
 
 export type SensorKey = 'amonia' | 'water' | 'sabun1' | 'sabun2' | 'sabun3' | 'tisu1' | 'tisu2';
 export type DeviceSensorConfig = Record<SensorKey, boolean>;
+
+export interface DeviceParameterSet {
+  webUpdateIntervalMs: number;
+  averagingIntervalMs: number;
+  maxSendAttempts: number;
+  tlsTimeoutMs: number;
+  tlsHandshakeTimeoutS: number;
+}
+
+export interface ExperimentCohort {
+  name: string;
+  weight: number;
+  parameters: Partial<DeviceParameterSet>;
+}
+
+export type ExperimentStatus = 'active' | 'stopped';
+
+export interface ExperimentRecord {
+  id: string;
+  name: string;
+  status: ExperimentStatus;
+  cohorts: ExperimentCohort[];
+  createdAt: Date;
+  stoppedAt: Date | null;
+}
+
+export interface DeviceMetricReportRecord {
+  deviceId: string;
+  experimentId: string | null;
+  cohort: string;
+  paramsVersion: string;
+  windowMs: number;
+  samplesSent: number;
+  samplesMissed: number;
+  retries: number;
+  payloadBytes: number;
+  avgUplinkLatencyMs: number;
+  maxUplinkLatencyMs: number;
+  minFreeHeap: number;
+}
+
+export interface CohortMetricSummary {
+  cohort: string;
+  reports: number;
+  devices: number;
+  samplesSent: number;
+  samplesMissed: number;
+  missRate: number | null;
+  retriesPerSample: number | null;
+  bytesPerSample: number | null;
+  avgUplinkLatencyMs: number | null;
+  maxUplinkLatencyMs: number | null;
+  minFreeHeap: number | null;
+}
+
+export type AlertNumericField =
+  | 'amonia.ppm'
+  | 'amonia.score'
+  | 'water.digital'
+  | 'sabun1.distance'
+  | 'sabun2.distance'
+  | 'sabun3.distance'
+  | 'tisu1.digital'
+  | 'tisu2.digital';
+
+export type AlertStatusField =
+  | 'amonia.status'
+  | 'water.status'
+  | 'sabun1.status'
+  | 'sabun2.status'
+  | 'sabun3.status'
+  | 'tisu1.status'
+  | 'tisu2.status';
+
+export type AlertCondition =
+  | { type: 'threshold'; field: AlertNumericField; op: 'gt' | 'gte' | 'lt' | 'lte'; value: number; clearValue?: number }
+  | { type: 'status'; field: AlertStatusField; equals: string[] }
+  | { type: 'timeOfDay'; from: string; to: string; days?: number[] }
+  | { type: 'all'; conditions: AlertCondition[] }
+  | { type: 'any'; conditions: AlertCondition[] }
+  | { type: 'not'; condition: AlertCondition };
+
+export interface AlertRuleDefinition {
+  message: string;
+  condition: AlertCondition;
+  forMs: number;
+  clearForMs: number;
+}
+
+export interface AlertRuleRecord {
+  id: string;
+  name: string;
+  deviceId: string | null;
+  lantai: number | null;
+  enabled: boolean;
+  definition: unknown;
+  createdAt: Date;
+  updatedAt: Date;
+}
+
+export interface AlertRuleInput {
+  name: string;
+  deviceId: string | null;
+  lantai: number | null;
+  enabled: boolean;
+  definition: AlertRuleDefinition;
+}
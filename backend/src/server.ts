@@ -1,10 +1,8 @@
-import { randomUUID } from 'node:crypto';
+import { createHash, randomUUID } from 'node:crypto';
 import { createServer } from 'node:http';
 import type { IncomingMessage } from 'node:http';
 import bcrypt from 'bcrypt';
-import cors from 'cors';
-import type { CorsOptions } from 'cors';
-import express, { NextFunction, Request, Response } from 'express';
+import express, { Request, Response } from 'express';
 import rateLimit from 'express-rate-limit';
 import jwt from 'jsonwebtoken';
 import type { JwtPayload, Secret, SignOptions } from 'jsonwebtoken';
@@ -17,15 +15,35 @@ import { WebSocketServer, WebSocket } from 'ws';
 
 import type { $Enums } from '@prisma/client';
 
+import { AlertRuleEngine, alertRuleDefinitionSchema, BUILTIN_ALERT_RULES } from './alerts/alertRuleEngine';
+import type { FiringAlert } from './alerts/alertRuleEngine';
 import { appConfig, getConfiguredApiKeys, isAllowedOrigin, isValidApiKey } from './config';
-import { prisma } from './database/prismaClient';
+import { corsErrorHandler, createCorsMiddleware } from './corsPolicy';
+import { DEFAULT_SENSOR_CONFIG, DeviceSensorSettingsCache, normalizeSensorConfig } from './deviceSensorSettings';
+import { prisma, replicaPrisma } from './database/prismaClient';
+import { ReadRouter } from './database/readRouter';
+import { EventLoopMonitor } from './eventLoopMonitor';
+import { IngestAccessLog } from './ingestAccessLog';
 import { accessLogger, appLogger } from './logger';
+import { AlertRuleRepository } from './repositories/alertRuleRepository';
 import { ConfigOverrideRepository } from './repositories/configOverrideRepository';
 import { DeviceSettingsRepository } from './repositories/deviceSettingsRepository';
-import { HistoryRepository } from './repositories/historyRepository';
+import { ExperimentRepository } from './repositories/experimentRepository';
+import { decodeHistoryCursor, encodeHistoryCursor, HistoryRepository } from './repositories/historyRepository';
+import type { HistoryCursor } from './repositories/historyRepository';
 import { LatestSnapshotRepository } from './repositories/latestSnapshotRepository';
 import { TelegramSubscriberRepository } from './repositories/telegramSubscriberRepository';
-import type { DeviceSensorConfig, SensorKey, SnapshotRecord } from './repositories/types';
+import { TelegramUpdateQueue } from './telegram/telegramUpdateQueue';
+import { createTelegramWebhookHandler, TELEGRAM_WEBHOOK_PATH } from './telegram/telegramWebhook';
+import type {
+  AlertRuleRecord,
+  DeviceParameterSet,
+  DeviceSensorConfig,
+  ExperimentCohort,
+  ExperimentRecord,
+  SensorKey,
+  SnapshotRecord
+} from './repositories/types';
 
 type UserRole = $Enums.UserRole;
 
@@ -46,7 +64,6 @@ declare global {
 }
 
 type EspStatus = 'active' | 'inactive';
-type SoapStatus = 'safe' | 'pending' | 'critical';
 type AlertType = 'accident_new' | 'accident_repeat' | 'recovery' | 'routine';
 
 interface ConfigBase {
@@ -61,8 +78,6 @@ interface Config extends ConfigBase {
   maxAlertDurationMs: number;
 }
 
-type DeviceSensorConfigMap = Record<string, DeviceSensorConfig>;
-
 interface PetugasAssignment {
   lantai: number;
 }
@@ -72,7 +87,9 @@ const rawSensorPayloadSchema = z.object({
   amonia: z.unknown().optional(),
   waterPuddleJson: z.unknown().optional(),
   sabun: z.unknown().optional(),
-  tisu: z.unknown().optional()
+  tisu: z.unknown().optional(),
+  // Set by the firmware on samples replayed from its pending queue: how long ago it was captured.
+  ageMs: z.number().int().nonnegative().optional()
 });
 
 type RawSensorPayload = z.infer<typeof rawSensorPayloadSchema>;
@@ -95,8 +112,6 @@ interface DeviceStatus {
   alertStartTime: number;
   lastAlertSentTime: number;
   isRecoverySent: boolean;
-  soapStatusConfirmed: SoapStatus;
-  soapPendingStartTime: number;
 }
 
 interface AmmoniaSensorData {
@@ -173,16 +188,8 @@ interface ComputedSensorSnapshot {
   tisu: TissueSensorData;
 }
 
-const SENSOR_KEYS: SensorKey[] = ['amonia', 'water', 'sabun1', 'sabun2', 'sabun3', 'tisu1', 'tisu2'];
-const DEFAULT_SENSOR_CONFIG: DeviceSensorConfig = {
-  amonia: true,
-  water: true,
-  sabun1: true,
-  sabun2: true,
-  sabun3: true,
-  tisu1: true,
-  tisu2: true
-};
+const SOAP_SENSOR_KEYS: SensorKey[] = ['sabun1', 'sabun2', 'sabun3'];
+const TISSUE_SENSOR_KEYS: SensorKey[] = ['tisu1', 'tisu2'];
 
 const SOAP_EMPTY_THRESHOLD_CM = 10;
 const TISSUE_EMPTY_VALUE = 0;
@@ -191,16 +198,40 @@ const AMMONIA_SCORE_SLOPE = 1.989;
 const AMMONIA_MIN_SCORE = 1;
 const AMMONIA_MAX_SCORE = 3;
 
-const SOAP_DEBOUNCE_MS = 5000;
 const ESP_INACTIVE_THRESHOLD_MS = 30000;
 const INACTIVITY_CHECK_INTERVAL_MS = 5000;
 
 const latestSnapshotRepository = new LatestSnapshotRepository(prisma);
 const WEBSOCKET_PING_INTERVAL_MS = 30000;
-const historyRepository = new HistoryRepository(prisma);
+const readRouter = new ReadRouter(
+  prisma,
+  replicaPrisma,
+  { maxLagMs: appConfig.database.replicaMaxLagMs, lagCheckIntervalMs: appConfig.database.replicaLagCheckIntervalMs },
+  appLogger.child({ subsystem: 'read-router' })
+);
+const historyRepository = new HistoryRepository(prisma, readRouter);
 const subscriberRepository = new TelegramSubscriberRepository(prisma);
 const configRepository = new ConfigOverrideRepository(prisma);
 const deviceSettingsRepository = new DeviceSettingsRepository(prisma);
+const experimentRepository = new ExperimentRepository(prisma);
+const alertRuleRepository = new AlertRuleRepository(prisma);
+const alertRuleEngine = new AlertRuleEngine(appConfig.alerts.timeZone, appLogger.child({ subsystem: 'alert-rules' }));
+const eventLoopMonitor = new EventLoopMonitor(
+  appConfig.eventLoopLag.windowMs,
+  appLogger.child({ subsystem: 'event-loop' }),
+  () => ({ telegramUpdateMode: appConfig.telegram.updateMode })
+);
+
+// Firmware defaults; cohorts only override the keys they are experimenting with.
+const DEFAULT_DEVICE_PARAMETERS: DeviceParameterSet = {
+  webUpdateIntervalMs: 1000,
+  averagingIntervalMs: 5 * 60 * 1000,
+  maxSendAttempts: 3,
+  tlsTimeoutMs: 15000,
+  tlsHandshakeTimeoutS: 15
+};
+const DEFAULT_PARAMS_VERSION = 'default';
+const DEFAULT_COHORT = 'default';
 
 const DEFAULT_CONFIG_BASE: ConfigBase = {
   historicalIntervalMinutes: 5,
@@ -212,7 +243,8 @@ const DEFAULT_CONFIG = deriveConfig(DEFAULT_CONFIG_BASE);
 
 let config: Config = DEFAULT_CONFIG;
 let petugas: Record<string, PetugasAssignment> = {};
-const deviceSensorSettings: DeviceSensorConfigMap = {};
+const deviceSensorSettings = new DeviceSensorSettingsCache(deviceSettingsRepository);
+let activeExperiment: ExperimentRecord | null = null;
 
 interface DeviceMuteEntry {
   mutedUntil: number;
@@ -258,12 +290,17 @@ setInterval(() => {
   });
 }, INACTIVITY_CHECK_INTERVAL_MS);
 
-function broadcastLatestSnapshot(snapshot: LatestDeviceSnapshot): void {
+const deviceStateLogger = appLogger.child({ subsystem: 'device-state' });
+const deviceStateEvictions = { retired: 0, overCapacity: 0, orphaned: 0, pendingAlertActions: 0, expiredMutes: 0 };
+
+setInterval(() => sweepDeviceState(), appConfig.deviceState.sweepIntervalMs).unref();
+
+function broadcastWebSocketMessage(type: 'snapshot' | 'history', payload: LatestDeviceSnapshot): void {
   if (websocketClients.size === 0) {
     return;
   }
 
-  const message = JSON.stringify({ type: 'snapshot', payload: snapshot });
+  const message = JSON.stringify({ type, payload });
   websocketClients.forEach(client => {
     if (client.readyState === WebSocket.OPEN) {
       client.send(message);
@@ -271,6 +308,16 @@ function broadcastLatestSnapshot(snapshot: LatestDeviceSnapshot): void {
   });
 }
 
+function broadcastLatestSnapshot(snapshot: LatestDeviceSnapshot): void {
+  broadcastWebSocketMessage('snapshot', snapshot);
+}
+
+// Pushed after a history row commits so dashboards can append it to their cached
+// first page instead of re-polling /api/history for every device.
+function broadcastHistoryAppend(entry: LatestDeviceSnapshot): void {
+  broadcastWebSocketMessage('history', entry);
+}
+
 function updateLatestData(
   deviceID: string,
   updater: (previous: LatestDeviceSnapshot | undefined) => LatestDeviceSnapshot
@@ -281,6 +328,110 @@ function updateLatestData(
   return updated;
 }
 
+// Drops the in-memory working state kept for a device: alert state, history throttle, cached
+// settings, ack buttons and rule-engine caches. The latest snapshot stays in latestData because
+// /api/latest serves it, so the device remains listed as inactive; mutes expire on their own.
+function evictDeviceState(deviceID: string): void {
+  delete deviceStatuses[deviceID];
+  delete lastHistoricalSaveTime[deviceID];
+  deviceSensorSettings.delete(deviceID);
+  deviceAcknowledgements.delete(deviceID);
+  pendingAlertActions.forEach((entry, ackId) => {
+    if (entry.deviceID === deviceID) {
+      pendingAlertActions.delete(ackId);
+    }
+  });
+  alertRuleEngine.forgetDevice(deviceID);
+}
+
+/**
+ * Keeps per-device working state bounded: it is evicted for devices silent for longer than the
+ * retention window, then for the least recently active ones while more than maxDevices still
+ * hold any. latestData is never evicted; it mirrors the latest-snapshot table that the dashboard
+ * lists. Entries that only ever expire on read (mutes, unanswered ack buttons) are pruned by
+ * age, and state left behind for devices without a snapshot (loaded at boot from settings or
+ * history) is dropped.
+ */
+function sweepDeviceState(now = Date.now()): void {
+  const { retentionMs, maxDevices, pendingAlertActionTtlMs } = appConfig.deviceState;
+  const before = { ...deviceStateEvictions };
+
+  Object.values(latestData).forEach(entry => {
+    // Retired devices stay listed, so only count the sweep that actually frees their state.
+    if (now - entry.lastActive > retentionMs && holdsDeviceState(entry.deviceID)) {
+      evictDeviceState(entry.deviceID);
+      deviceStateEvictions.retired += 1;
+    }
+  });
+
+  const holding = Object.values(latestData).filter(entry => holdsDeviceState(entry.deviceID));
+  if (holding.length > maxDevices) {
+    holding
+      .sort((a, b) => a.lastActive - b.lastActive)
+      .slice(0, holding.length - maxDevices)
+      .forEach(entry => {
+        evictDeviceState(entry.deviceID);
+        deviceStateEvictions.overCapacity += 1;
+      });
+  }
+
+  const orphanKeys = new Set([
+    ...Object.keys(deviceStatuses),
+    ...Object.keys(lastHistoricalSaveTime),
+    ...deviceSensorSettings.keys(),
+    ...deviceAcknowledgements.keys()
+  ]);
+  orphanKeys.forEach(deviceID => {
+    if (!latestData[deviceID]) {
+      evictDeviceState(deviceID);
+      deviceStateEvictions.orphaned += 1;
+    }
+  });
+
+  deviceMuteState.forEach((entry, deviceID) => {
+    if (entry.mutedUntil <= now) {
+      deviceMuteState.delete(deviceID);
+      deviceStateEvictions.expiredMutes += 1;
+    }
+  });
+
+  pendingAlertActions.forEach((entry, ackId) => {
+    if (now - entry.sentAt > pendingAlertActionTtlMs) {
+      pendingAlertActions.delete(ackId);
+      deviceStateEvictions.pendingAlertActions += 1;
+    }
+  });
+
+  const evicted = Object.fromEntries(
+    Object.entries(deviceStateEvictions).map(([key, value]) => [key, value - before[key as keyof typeof before]])
+  );
+  if (Object.values(evicted).some(count => count > 0)) {
+    deviceStateLogger.info({ evicted, ...getDeviceStateSizes() }, 'Evicted stale device state');
+  }
+}
+
+function holdsDeviceState(deviceID: string): boolean {
+  return (
+    deviceID in deviceStatuses ||
+    deviceID in lastHistoricalSaveTime ||
+    deviceSensorSettings.has(deviceID) ||
+    deviceAcknowledgements.has(deviceID) ||
+    alertRuleEngine.hasDeviceState(deviceID)
+  );
+}
+
+function getDeviceStateSizes(): Record<string, number> {
+  return {
+    latestData: Object.keys(latestData).length,
+    deviceStatuses: Object.keys(deviceStatuses).length,
+    lastHistoricalSaveTime: Object.keys(lastHistoricalSaveTime).length,
+    deviceSensorSettings: deviceSensorSettings.size,
+    deviceMuteState: deviceMuteState.size,
+    pendingAlertActions: pendingAlertActions.size,
+    deviceAcknowledgements: deviceAcknowledgements.size
+  };
+}
+
 async function markInactiveDevices(now = Date.now()): Promise<void> {
   const updates: Promise<void>[] = [];
 
@@ -315,29 +466,14 @@ if (configuredApiKeys.length === 0) {
 
 app.set('trust proxy', appConfig.trustProxy);
 
-const corsOptions: CorsOptions = {
-  origin: (origin, callback) => {
-    if (!origin) {
-      if (appConfig.allowRequestsWithoutOrigin) {
-        callback(null, true);
-      } else {
-        callback(new Error('Origin header is required.'));
-      }
-      return;
-    }
-
-    if (isAllowedOrigin(origin)) {
-      callback(null, true);
-      return;
-    }
-
-    callback(new Error(`Origin ${origin} is not allowed.`));
-  },
-  credentials: true
-};
+const corsMiddleware = createCorsMiddleware({
+  allowRequestsWithoutOrigin: appConfig.allowRequestsWithoutOrigin,
+  isAllowedOrigin,
+  exemptPaths: appConfig.telegram.updateMode === 'webhook' ? [TELEGRAM_WEBHOOK_PATH] : []
+});
 
-app.use(cors(corsOptions));
-app.options('*', cors(corsOptions));
+app.use(corsMiddleware);
+app.options('*', corsMiddleware);
 
 const requestMetadataMiddleware: express.RequestHandler = (req, _res, next) => {
   const cfConnectingIpHeader = req.headers['cf-connecting-ip'];
@@ -361,6 +497,8 @@ const requestMetadataMiddleware: express.RequestHandler = (req, _res, next) => {
   next();
 };
 
+const ingestAccessLog = new IngestAccessLog(appConfig.ingestAccessLog, accessLogger);
+
 const httpLogger = pinoHttp<Request, Response>({
   logger: accessLogger,
   genReqId: request => {
@@ -385,7 +523,10 @@ const httpLogger = pinoHttp<Request, Response>({
       latencyMs: latency
     };
   },
-  customLogLevel: (_req, res, err) => {
+  customLogLevel: (req, res, err) => {
+    if (!ingestAccessLog.shouldLog(req, res, err)) {
+      return 'silent';
+    }
     if (err || res.statusCode >= 500) {
       return 'error';
     }
@@ -400,6 +541,7 @@ const httpLogger = pinoHttp<Request, Response>({
 });
 
 app.use(requestMetadataMiddleware);
+app.use(ingestAccessLog.middleware);
 app.use(httpLogger);
 
 const cloudflareAuthMiddleware: express.RequestHandler = (req, res, next) => {
@@ -420,6 +562,8 @@ const requestRateLimiter = rateLimit({
   standardHeaders: true,
   legacyHeaders: false,
   keyGenerator: req => req.clientIp ?? req.ip ?? req.socket.remoteAddress ?? 'unknown',
+  // Telegram delivers every chat update from a handful of addresses; bursts are absorbed by the update queue.
+  skip: req => appConfig.telegram.updateMode === 'webhook' && req.path === TELEGRAM_WEBHOOK_PATH,
   message: 'Too many requests. Please try again later.'
 });
 
@@ -444,6 +588,66 @@ const sensorConfigSchema = z.object({
   })
 });
 
+const deviceParametersSchema = z
+  .object({
+    webUpdateIntervalMs: z.number().int().min(500).max(60_000),
+    averagingIntervalMs: z.number().int().min(10_000).max(30 * 60 * 1000),
+    maxSendAttempts: z.number().int().min(1).max(5),
+    tlsTimeoutMs: z.number().int().min(2000).max(30_000),
+    tlsHandshakeTimeoutS: z.number().int().min(2).max(30)
+  })
+  .partial()
+  .strict();
+
+const experimentCreateSchema = z.object({
+  name: z.string().trim().min(1, 'name is required').max(100),
+  cohorts: z
+    .array(
+      z.object({
+        name: z
+          .string()
+          .trim()
+          .regex(/^[a-z0-9_-]{1,32}$/, 'Cohort names must be 1-32 characters of a-z, 0-9, _ or -.'),
+        weight: z.number().positive(),
+        parameters: deviceParametersSchema
+      })
+    )
+    .min(2, 'An experiment needs at least two cohorts.')
+    .max(8)
+    .refine(cohorts => new Set(cohorts.map(cohort => cohort.name)).size === cohorts.length, {
+      message: 'Cohort names must be unique.'
+    })
+});
+
+const deviceMetricsSchema = z.object({
+  cohort: z.string().trim().min(1).max(32),
+  paramsVersion: z.string().trim().min(1).max(80),
+  windowMs: z.number().int().nonnegative(),
+  samplesSent: z.number().int().nonnegative(),
+  samplesMissed: z.number().int().nonnegative(),
+  retries: z.number().int().nonnegative(),
+  payloadBytes: z.number().int().nonnegative(),
+  avgUplinkLatencyMs: z.number().nonnegative(),
+  maxUplinkLatencyMs: z.number().nonnegative(),
+  minFreeHeap: z.number().int().nonnegative()
+});
+
+const alertRuleInputSchema = z
+  .object({
+    name: z
+      .string()
+      .trim()
+      .regex(/^[a-z0-9_-]{1,64}$/, 'Rule names must be 1-64 characters of a-z, 0-9, _ or -.'),
+    deviceId: z.string().trim().min(1).max(100).nullable().default(null),
+    lantai: z.number().int().min(1).nullable().default(null),
+    enabled: z.boolean().default(true),
+    definition: alertRuleDefinitionSchema
+  })
+  .refine(rule => rule.deviceId === null || rule.lantai === null, {
+    message: 'A rule targets either one device or one floor, not both.',
+    path: ['lantai']
+  });
+
 const loginSchema = z.object({
   email: z
     .string({ required_error: 'Email is required.' })
@@ -654,7 +858,7 @@ wss.on('connection', (socket: WebSocket, request: IncomingMessage) => {
   });
 });
 
-const telegramBot = createTelegramBot(process.env.TELEGRAM_BOT_TOKEN, process.env.TELEGRAM_POLLING === 'false');
+const telegramBot = createTelegramBot(process.env.TELEGRAM_BOT_TOKEN);
 const telegramLogger = appLogger.child({ subsystem: 'telegram' });
 
 if (telegramBot) {
@@ -840,23 +1044,20 @@ if (telegramBot) {
         { digital: -1, status: 'Data tidak ada' },
         telegramLogger
       );
-      const soap = parseJson<SoapSensorData>(data.sabun, defaultSoapData(), telegramLogger);
-      const tissue = parseJson<TissueSensorData>(data.tisu, defaultTissueData(), telegramLogger);
       const timestamp = new Date(data.timestamp).toLocaleString();
 
-      const isAnySoapCritical =
-        soap.sabun1.status === 'Habis' || soap.sabun2.status === 'Habis' || soap.sabun3.status === 'Habis';
-      const isAnyTissueCritical = tissue.tisu1.status === 'Habis' || tissue.tisu2.status === 'Habis';
-
-      const soapStatusKeseluruhan = isAnySoapCritical ? 'HAMPIR HABIS' : 'Aman';
-      const tissueStatusKeseluruhan = isAnyTissueCritical ? 'HAMPIR HABIS' : 'Tersedia';
+      // Same verdict as the alerts: whatever the rule engine left firing for the last sample.
+      const firingAlerts = alertRuleEngine.firing(deviceID, assignment.lantai);
+      const soapStatusKeseluruhan = isAlertingOn(firingAlerts, SOAP_SENSOR_KEYS) ? 'HAMPIR HABIS' : 'Aman';
+      const tissueStatusKeseluruhan = isAlertingOn(firingAlerts, TISSUE_SENSOR_KEYS) ? 'HAMPIR HABIS' : 'Tersedia';
 
       const payload = [
         `LAPORAN STATUS ${deviceID.toUpperCase().replace('-', ' ')} (REAL-TIME: ${timestamp}):`,
         `Bau: ${amonia.status} (${Number.isFinite(amonia.ppm) ? `${amonia.ppm} ppm` : 'Data tidak ada'})`,
         `Genangan Air: ${water.status}`,
         `Sabun: ${soapStatusKeseluruhan}`,
-        `Tisu: ${tissueStatusKeseluruhan}`
+        `Tisu: ${tissueStatusKeseluruhan}`,
+        ...(firingAlerts.length > 0 ? [`Alert aktif: ${firingAlerts.map(alert => alert.message).join(', ')}`] : [])
       ].join('\n');
 
       telegramBot.sendMessage(msg.chat.id, payload);
@@ -907,6 +1108,29 @@ if (telegramBot) {
   });
 }
 
+const telegramUpdateQueue =
+  telegramBot && appConfig.telegram.updateMode === 'webhook'
+    ? new TelegramUpdateQueue(
+        update => telegramBot.processUpdate(update),
+        {
+          batchSize: appConfig.telegram.updateBatchSize,
+          batchIntervalMs: appConfig.telegram.updateBatchIntervalMs,
+          maxQueuedUpdates: appConfig.telegram.maxQueuedUpdates
+        },
+        telegramLogger
+      )
+    : null;
+
+if (telegramUpdateQueue) {
+  app.post(
+    TELEGRAM_WEBHOOK_PATH,
+    createTelegramWebhookHandler(telegramUpdateQueue, {
+      secret: appConfig.telegram.webhookSecret,
+      retryAfterSeconds: Math.ceil(appConfig.telegram.updateBatchIntervalMs / 1000)
+    })
+  );
+}
+
 app.get('/healthz', (_req: Request, res: Response) => {
   res.status(200).json({ status: 'ok', timestamp: new Date().toISOString() });
 });
@@ -916,6 +1140,13 @@ app.get('/readyz', (_req: Request, res: Response) => {
   res.status(ready === 'ready' ? 200 : 503).json({
     status: ready,
     telegram: telegramBot ? 'connected' : 'disabled',
+    telegramUpdates: {
+      mode: telegramBot ? appConfig.telegram.updateMode : 'off',
+      queue: telegramUpdateQueue ? telegramUpdateQueue.status() : null
+    },
+    eventLoop: eventLoopMonitor.status(),
+    deviceState: { sizes: getDeviceStateSizes(), evictions: deviceStateEvictions },
+    readReplica: readRouter.status(),
     timestamp: new Date().toISOString()
   });
 });
@@ -992,7 +1223,7 @@ app.get('/api/device/:deviceId/settings', authenticateRequest, async (req: Reque
   const { deviceId } = req.params;
 
   try {
-    const sensorConfig = await getDeviceSensorConfig(deviceId);
+    const sensorConfig = await deviceSensorSettings.read(deviceId);
     res.status(200).json({ deviceId, sensorConfig });
   } catch (error) {
     req.log.error({ err: error, deviceId }, 'Failed to load device settings');
@@ -1017,7 +1248,7 @@ app.post(
 
     try {
       await deviceSettingsRepository.upsert(deviceId, normalizedConfig);
-      deviceSensorSettings[deviceId] = normalizedConfig;
+      deviceSensorSettings.set(deviceId, normalizedConfig);
 
       if (latestData[deviceId]) {
         updateLatestData(deviceId, previous => ({ ...previous!, sensorConfig: normalizedConfig }));
@@ -1045,9 +1276,34 @@ app.post('/data', requireApiKey, async (req: Request, res: Response) => {
   const now = Date.now();
   const normalized = normalizeSensorPayload(payload, req.log);
   const computedSnapshot = computeSensorSnapshot(normalized);
-  const sensorConfig = await getDeviceSensorConfig(deviceID);
+  const sensorConfig = await deviceSensorSettings.get(deviceID);
   const serializedSnapshot = serializeComputedSnapshot(computedSnapshot);
 
+  if (payload.ageMs) {
+    // A replayed sample belongs in history at its capture time, but must not replace the current
+    // reading or raise/clear alerts; the device sends a fresh sample right after its backlog.
+    const capturedAt = new Date(now - payload.ageMs);
+    const previous = latestData[deviceID];
+    if (!previous) {
+      req.log.warn({ deviceId: deviceID, ageMs: payload.ageMs }, '[Historical Log] Dropping replayed sample from unknown device');
+    } else {
+      try {
+        await historyRepository.record({
+          deviceId: deviceID,
+          displayName: previous.displayName ?? null,
+          ...serializedSnapshot,
+          timestamp: capturedAt,
+          espStatus: 'active',
+          lastActive: capturedAt
+        });
+      } catch (err) {
+        req.log.error({ err, deviceId: deviceID }, '[Historical Log] Failed to write replayed sample');
+      }
+    }
+    res.status(200).send(`Data from ${deviceID} received successfully.`);
+    return;
+  }
+
   const latestSnapshot = updateLatestData(deviceID, previous => ({
     deviceID,
     amonia: serializedSnapshot.amonia,
@@ -1066,9 +1322,7 @@ app.post('/data', requireApiKey, async (req: Request, res: Response) => {
       isAlert: false,
       alertStartTime: 0,
       lastAlertSentTime: 0,
-      isRecoverySent: true,
-      soapStatusConfirmed: 'safe',
-      soapPendingStartTime: 0
+      isRecoverySent: true
     };
   }
 
@@ -1082,26 +1336,7 @@ app.post('/data', requireApiKey, async (req: Request, res: Response) => {
     req.log.error({ err: error, deviceId: deviceID }, '[Latest Snapshot] Failed to persist data');
   }
 
-  const soap = computedSnapshot.sabun;
-  const tissue = computedSnapshot.tisu;
-
-  const soapMonitoringEnabled = isAnySensorEnabled(sensorConfig, ['sabun1', 'sabun2', 'sabun3']);
-
-  const isAnySoapCritical = soapMonitoringEnabled && isSoapCritical(soap);
-
-  if (isAnySoapCritical) {
-    if (status.soapStatusConfirmed === 'safe') {
-      status.soapStatusConfirmed = 'pending';
-      status.soapPendingStartTime = now;
-    } else if (status.soapStatusConfirmed === 'pending' && now - status.soapPendingStartTime >= SOAP_DEBOUNCE_MS) {
-      status.soapStatusConfirmed = 'critical';
-    }
-  } else {
-    status.soapStatusConfirmed = 'safe';
-    status.soapPendingStartTime = 0;
-  }
-
-  const activeAlerts = getActiveAlerts(deviceID, status.soapStatusConfirmed, tissue, sensorConfig);
+  const activeAlerts = alertRuleEngine.evaluate(deviceID, lantai, computedSnapshot, sensorConfig, now);
   const isAlerting = activeAlerts.length > 0;
 
   if (isAlerting) {
@@ -1189,6 +1424,7 @@ app.post('/data', requireApiKey, async (req: Request, res: Response) => {
     try {
       await historyRepository.record(latestSnapshotRecord);
       lastHistoricalSaveTime[deviceID] = now;
+      broadcastHistoryAppend(latestSnapshot);
       if (!isAlerting) {
         const muteEntry = getActiveMuteEntry(deviceID);
         if (muteEntry) {
@@ -1218,6 +1454,210 @@ app.post('/data', requireApiKey, async (req: Request, res: Response) => {
   res.status(200).send(`Data from ${deviceID} received successfully.`);
 });
 
+app.get('/device/:deviceId/parameters', requireApiKey, (req: Request, res: Response) => {
+  const { deviceId } = req.params;
+  res.locals.deviceId = deviceId;
+  res.json(resolveDeviceParameters(deviceId));
+});
+
+app.post('/device/:deviceId/metrics', requireApiKey, async (req: Request, res: Response) => {
+  const { deviceId } = req.params;
+  res.locals.deviceId = deviceId;
+
+  const parseResult = deviceMetricsSchema.safeParse(req.body);
+  if (!parseResult.success) {
+    res.status(400).json({ error: 'Invalid metrics payload.', details: parseResult.error.flatten() });
+    return;
+  }
+
+  const metrics = parseResult.data;
+  // Reports are attributed by the parameters the device says it ran with, so a device that has
+  // not picked up a new assignment yet does not pollute the new cohort.
+  const experimentId =
+    activeExperiment && metrics.paramsVersion.startsWith(`${activeExperiment.id}:`) ? activeExperiment.id : null;
+
+  try {
+    await experimentRepository.recordMetrics({ deviceId, experimentId, ...metrics });
+    res.status(204).end();
+  } catch (error) {
+    req.log.error({ err: error, deviceId }, 'Failed to persist device metrics');
+    res.status(500).json({ error: 'Failed to persist device metrics.' });
+  }
+});
+
+app.get('/api/experiments', authenticateRequest, requireSupervisor, async (req: Request, res: Response) => {
+  try {
+    const experiments = await experimentRepository.list();
+    res.json({ experiments, defaults: DEFAULT_DEVICE_PARAMETERS });
+  } catch (error) {
+    req.log.error({ err: error }, 'Failed to list experiments');
+    res.status(500).json({ error: 'Failed to list experiments.' });
+  }
+});
+
+app.post('/api/experiments', authenticateRequest, requireSupervisor, async (req: Request, res: Response) => {
+  const parseResult = experimentCreateSchema.safeParse(req.body);
+  if (!parseResult.success) {
+    res.status(400).json({ error: 'Invalid experiment payload.', details: parseResult.error.flatten() });
+    return;
+  }
+
+  if (activeExperiment) {
+    res.status(409).json({ error: 'Another experiment is already active.', experimentId: activeExperiment.id });
+    return;
+  }
+
+  try {
+    const experiment = await experimentRepository.create(parseResult.data.name, parseResult.data.cohorts);
+    activeExperiment = experiment;
+    req.log.info({ experimentId: experiment.id, cohorts: experiment.cohorts.length }, 'Experiment started');
+    res.status(201).json(experiment);
+  } catch (error) {
+    if ((error as { code?: string }).code === 'P2002') {
+      res.status(409).json({ error: 'Another experiment is already active.' });
+      return;
+    }
+    req.log.error({ err: error }, 'Failed to create experiment');
+    res.status(500).json({ error: 'Failed to create experiment.' });
+  }
+});
+
+app.post('/api/experiments/:id/stop', authenticateRequest, requireSupervisor, async (req: Request, res: Response) => {
+  const { id } = req.params;
+
+  try {
+    const experiment = await experimentRepository.stop(id);
+    if (activeExperiment?.id === id) {
+      activeExperiment = null;
+    }
+    req.log.info({ experimentId: id }, 'Experiment stopped');
+    res.json(experiment);
+  } catch (error) {
+    if ((error as { code?: string }).code === 'P2025') {
+      res.status(404).json({ error: 'Experiment not found.' });
+      return;
+    }
+    req.log.error({ err: error, experimentId: id }, 'Failed to stop experiment');
+    res.status(500).json({ error: 'Failed to stop experiment.' });
+  }
+});
+
+app.get('/api/experiments/:id/report', authenticateRequest, requireSupervisor, async (req: Request, res: Response) => {
+  const { id } = req.params;
+
+  try {
+    const experiment = await experimentRepository.findById(id);
+    if (!experiment) {
+      res.status(404).json({ error: 'Experiment not found.' });
+      return;
+    }
+
+    const cohorts = await experimentRepository.summarizeCohorts(id);
+    res.json({
+      experiment,
+      cohorts: experiment.cohorts.map(cohort => ({
+        name: cohort.name,
+        weight: cohort.weight,
+        parameters: { ...DEFAULT_DEVICE_PARAMETERS, ...cohort.parameters },
+        metrics: cohorts.find(summary => summary.cohort === cohort.name) ?? null
+      }))
+    });
+  } catch (error) {
+    req.log.error({ err: error, experimentId: id }, 'Failed to build experiment report');
+    res.status(500).json({ error: 'Failed to build experiment report.' });
+  }
+});
+
+async function reloadAlertRules(): Promise<AlertRuleRecord[]> {
+  const rules = await alertRuleRepository.list();
+  alertRuleEngine.setRules(rules);
+  return rules;
+}
+
+app.get('/api/alert-rules', authenticateRequest, requireSupervisor, async (req: Request, res: Response) => {
+  try {
+    const rules = await alertRuleRepository.list();
+    res.json({ rules, builtIn: BUILTIN_ALERT_RULES, timeZone: appConfig.alerts.timeZone });
+  } catch (error) {
+    req.log.error({ err: error }, 'Failed to list alert rules');
+    res.status(500).json({ error: 'Failed to list alert rules.' });
+  }
+});
+
+app.post('/api/alert-rules', authenticateRequest, requireSupervisor, async (req: Request, res: Response) => {
+  const parseResult = alertRuleInputSchema.safeParse(req.body);
+  if (!parseResult.success) {
+    res.status(400).json({ error: 'Invalid alert rule payload.', details: parseResult.error.flatten() });
+    return;
+  }
+
+  try {
+    const rule = await alertRuleRepository.create(parseResult.data);
+    await reloadAlertRules();
+    req.log.info({ ruleId: rule.id, ruleName: rule.name, deviceId: rule.deviceId, lantai: rule.lantai }, 'Alert rule created');
+    res.status(201).json(rule);
+  } catch (error) {
+    if ((error as { code?: string }).code === 'P2002') {
+      res.status(409).json({ error: 'A rule with this name already exists for this scope.' });
+      return;
+    }
+    req.log.error({ err: error }, 'Failed to create alert rule');
+    res.status(500).json({ error: 'Failed to create alert rule.' });
+  }
+});
+
+app.put('/api/alert-rules/:id', authenticateRequest, requireSupervisor, async (req: Request, res: Response) => {
+  const { id } = req.params;
+  const parseResult = alertRuleInputSchema.safeParse(req.body);
+  if (!parseResult.success) {
+    res.status(400).json({ error: 'Invalid alert rule payload.', details: parseResult.error.flatten() });
+    return;
+  }
+
+  try {
+    const rule = await alertRuleRepository.update(id, parseResult.data);
+    await reloadAlertRules();
+    req.log.info({ ruleId: id, ruleName: rule.name }, 'Alert rule updated');
+    res.json(rule);
+  } catch (error) {
+    const code = (error as { code?: string }).code;
+    if (code === 'P2025') {
+      res.status(404).json({ error: 'Alert rule not found.' });
+      return;
+    }
+    if (code === 'P2002') {
+      res.status(409).json({ error: 'A rule with this name already exists for this scope.' });
+      return;
+    }
+    req.log.error({ err: error, ruleId: id }, 'Failed to update alert rule');
+    res.status(500).json({ error: 'Failed to update alert rule.' });
+  }
+});
+
+app.delete('/api/alert-rules/:id', authenticateRequest, requireSupervisor, async (req: Request, res: Response) => {
+  const { id } = req.params;
+
+  try {
+    await alertRuleRepository.delete(id);
+    await reloadAlertRules();
+    req.log.info({ ruleId: id }, 'Alert rule deleted');
+    res.status(204).end();
+  } catch (error) {
+    if ((error as { code?: string }).code === 'P2025') {
+      res.status(404).json({ error: 'Alert rule not found.' });
+      return;
+    }
+    req.log.error({ err: error, ruleId: id }, 'Failed to delete alert rule');
+    res.status(500).json({ error: 'Failed to delete alert rule.' });
+  }
+});
+
+app.get('/api/device/:deviceId/alert-rules', authenticateRequest, (req: Request, res: Response) => {
+  const { deviceId } = req.params;
+  const lantai = extractFloorFromDeviceID(deviceId);
+  res.json({ deviceId, lantai, rules: alertRuleEngine.describe(deviceId, lantai) });
+});
+
 app.get('/api/latest', authenticateRequest, async (_req: Request, res: Response) => {
   const now = Date.now();
   await markInactiveDevices(now);
@@ -1241,22 +1681,23 @@ app.get('/api/history', authenticateRequest, async (req: Request, res: Response)
   const { deviceId, cursor } = parseResult.data;
   const limit = parseResult.data.limit ?? 25;
 
-  let cursorValue: bigint | undefined;
+  let cursorValue: HistoryCursor | undefined;
   if (cursor) {
-    try {
-      cursorValue = BigInt(cursor);
-    } catch (error) {
+    const decodedCursor = decodeHistoryCursor(cursor);
+    if (!decodedCursor) {
       res.status(400).json({ error: 'Invalid cursor parameter.' });
       return;
     }
+    cursorValue = decodedCursor;
   }
 
   try {
     const { entries, nextCursor } = await historyRepository.findPaginatedByDevice(deviceId, limit, cursorValue);
+    const sensorConfig = await deviceSensorSettings.read(deviceId);
     const responsePayload = {
       deviceId,
-      entries: entries.map(toLatestDeviceSnapshot),
-      nextCursor: nextCursor ? nextCursor.toString() : null,
+      entries: entries.map(entry => toLatestDeviceSnapshot(entry, sensorConfig)),
+      nextCursor: nextCursor ? encodeHistoryCursor(nextCursor) : null,
       hasMore: Boolean(nextCursor)
     };
 
@@ -1307,13 +1748,7 @@ app.post(
   }
 );
 
-app.use((err: Error, _req: Request, res: Response, next: NextFunction) => {
-  if (err.message === 'Origin header is required.' || err.message.includes('is not allowed')) {
-    res.status(403).json({ error: err.message });
-    return;
-  }
-  next(err);
-});
+app.use(corsErrorHandler);
 
 bootstrap()
   .then(() => {
@@ -1323,6 +1758,7 @@ bootstrap()
         'Server is running'
       );
       appLogger.info('Waiting for data from ESP32s...');
+      void registerTelegramWebhook();
     });
   })
   .catch(error => {
@@ -1369,10 +1805,8 @@ function serializeComputedSnapshot(
   };
 }
 
-function isSoapCritical(soap: SoapSensorData): boolean {
-  return (
-    soap.sabun1.status === 'Habis' || soap.sabun2.status === 'Habis' || soap.sabun3.status === 'Habis'
-  );
+function isAlertingOn(alerts: FiringAlert[], keys: SensorKey[]): boolean {
+  return alerts.some(alert => alert.sensors.some(sensor => keys.includes(sensor)));
 }
 
 function normalizeAmmoniaPayload(value: unknown, logger: Logger): RawAmmoniaPayload {
@@ -1597,10 +2031,7 @@ function toSnapshotRecord(snapshot: LatestDeviceSnapshot): SnapshotRecord {
   };
 }
 
-function toLatestDeviceSnapshot(record: SnapshotRecord): LatestDeviceSnapshot {
-  const sensorConfig = normalizeSensorConfig(deviceSensorSettings[record.deviceId] ?? DEFAULT_SENSOR_CONFIG);
-  deviceSensorSettings[record.deviceId] = sensorConfig;
-
+function toLatestDeviceSnapshot(record: SnapshotRecord, sensorConfig: DeviceSensorConfig): LatestDeviceSnapshot {
   return {
     deviceID: record.deviceId,
     displayName: record.displayName,
@@ -1615,54 +2046,50 @@ function toLatestDeviceSnapshot(record: SnapshotRecord): LatestDeviceSnapshot {
   };
 }
 
-function normalizeSensorConfig(config: Partial<DeviceSensorConfig>): DeviceSensorConfig {
-  const normalized: DeviceSensorConfig = { ...DEFAULT_SENSOR_CONFIG };
-  SENSOR_KEYS.forEach(key => {
-    const value = config[key];
-    normalized[key] = typeof value === 'boolean' ? value : DEFAULT_SENSOR_CONFIG[key];
-  });
-  return normalized;
-}
-
-async function getDeviceSensorConfig(deviceID: string): Promise<DeviceSensorConfig> {
-  const existing = deviceSensorSettings[deviceID];
-  if (existing) {
-    return existing;
-  }
-
-  const stored = await deviceSettingsRepository.get(deviceID);
-  const normalized = normalizeSensorConfig(stored ?? DEFAULT_SENSOR_CONFIG);
-  deviceSensorSettings[deviceID] = normalized;
-  return normalized;
-}
-
 function isAnySensorEnabled(config: DeviceSensorConfig, keys: SensorKey[]): boolean {
   return keys.some(key => config[key]);
 }
 
-function getActiveAlerts(
-  _deviceID: string,
-  soapStatusConfirmed: SoapStatus,
-  tissue: TissueSensorData,
-  sensorConfig: DeviceSensorConfig
-): string[] {
-  const alerts: string[] = [];
-
-  if (isAnySensorEnabled(sensorConfig, ['sabun1', 'sabun2', 'sabun3']) && soapStatusConfirmed === 'critical') {
-    alerts.push('SABUN HAMPIR HABIS');
+function assignCohort(experiment: ExperimentRecord, deviceID: string): ExperimentCohort | null {
+  const totalWeight = experiment.cohorts.reduce((sum, cohort) => sum + cohort.weight, 0);
+  if (totalWeight <= 0) {
+    return null;
   }
 
-  const statusTisu1 = tissue.tisu1.status;
-  const statusTisu2 = tissue.tisu2.status;
+  // Stable per (experiment, device) so a device keeps its cohort across restarts and servers.
+  const digest = createHash('sha256').update(`${experiment.id}:${deviceID}`).digest();
+  let point = (digest.readUInt32BE(0) / 0x1_0000_0000) * totalWeight;
+  for (const cohort of experiment.cohorts) {
+    if (point < cohort.weight) {
+      return cohort;
+    }
+    point -= cohort.weight;
+  }
+  return experiment.cohorts[experiment.cohorts.length - 1];
+}
 
-  if (
-    (sensorConfig.tisu1 && statusTisu1 === 'Habis') ||
-    (sensorConfig.tisu2 && statusTisu2 === 'Habis')
-  ) {
-    alerts.push('TISU HAMPIR HABIS');
+function resolveDeviceParameters(deviceID: string): {
+  experimentId: string | null;
+  cohort: string;
+  paramsVersion: string;
+  parameters: DeviceParameterSet;
+} {
+  const cohort = activeExperiment ? assignCohort(activeExperiment, deviceID) : null;
+  if (!activeExperiment || !cohort) {
+    return {
+      experimentId: null,
+      cohort: DEFAULT_COHORT,
+      paramsVersion: DEFAULT_PARAMS_VERSION,
+      parameters: DEFAULT_DEVICE_PARAMETERS
+    };
   }
 
-  return alerts;
+  return {
+    experimentId: activeExperiment.id,
+    cohort: cohort.name,
+    paramsVersion: `${activeExperiment.id}:${cohort.name}`,
+    parameters: { ...DEFAULT_DEVICE_PARAMETERS, ...cohort.parameters }
+  };
 }
 
 function getDeviceIdForFloor(lantai: number): string {
@@ -1771,7 +2198,7 @@ function sendTelegramAlert(
   deviceID: string,
   sensorData: LatestDeviceSnapshot,
   lantai: number,
-  activeAlerts: string[],
+  activeAlerts: FiringAlert[],
   type: AlertType,
   sensorConfig: DeviceSensorConfig,
   context: { logger?: Logger; requestId?: string } = {}
@@ -1796,16 +2223,15 @@ function sendTelegramAlert(
   const timestamp = new Date(sensorData.timestamp).toLocaleString();
 
   const normalizedSensorConfig = normalizeSensorConfig(sensorData.sensorConfig ?? sensorConfig);
-  const soapEnabled = isAnySensorEnabled(normalizedSensorConfig, ['sabun1', 'sabun2', 'sabun3']);
-  const tissueEnabled = isAnySensorEnabled(normalizedSensorConfig, ['tisu1', 'tisu2']);
+  const soapEnabled = isAnySensorEnabled(normalizedSensorConfig, SOAP_SENSOR_KEYS);
+  const tissueEnabled = isAnySensorEnabled(normalizedSensorConfig, TISSUE_SENSOR_KEYS);
   const ammoniaEnabled = normalizedSensorConfig.amonia;
   const waterEnabled = normalizedSensorConfig.water;
 
-  const isAnySoapCritical = soapEnabled && isSoapCritical(soap);
-  const isAnyTissueCritical =
-    tissueEnabled &&
-    ((normalizedSensorConfig.tisu1 && tissue.tisu1.status === 'Habis') ||
-      (normalizedSensorConfig.tisu2 && tissue.tisu2.status === 'Habis'));
+  // Summary lines follow the firing rules, so a report never contradicts the alert it belongs to.
+  const isAnySoapCritical = soapEnabled && isAlertingOn(activeAlerts, SOAP_SENSOR_KEYS);
+  const isAnyTissueCritical = tissueEnabled && isAlertingOn(activeAlerts, TISSUE_SENSOR_KEYS);
+  const alertMessages = activeAlerts.map(alert => alert.message).join('\n');
 
   const soapStatusKeseluruhan = soapEnabled ? (isAnySoapCritical ? 'HAMPIR HABIS' : 'Aman') : 'Dinonaktifkan';
   const tissueStatusKeseluruhan = tissueEnabled ? (isAnyTissueCritical ? 'HAMPIR HABIS' : 'Tersedia') : 'Dinonaktifkan';
@@ -1819,18 +2245,17 @@ function sendTelegramAlert(
     const title = deviceID.toUpperCase().replace('-', ' ');
     switch (type) {
       case 'accident_new':
-        message = `🚨 MASALAH BARU TERDETEKSI di ${title} (${timestamp})!\n\n${activeAlerts.join('\n')}\n`;
+        message = `🚨 MASALAH BARU TERDETEKSI di ${title} (${timestamp})!\n\n${alertMessages}\n`;
         break;
       case 'accident_repeat':
-        message = `🔔 PENGINGAT (MASALAH BELUM TERATASI) di ${title} (${timestamp})!\n\n${activeAlerts.join('\n')}\n`;
+        message = `🔔 PENGINGAT (MASALAH BELUM TERATASI) di ${title} (${timestamp})!\n\n${alertMessages}\n`;
         break;
       case 'recovery':
-        message = `✅MASALAH SUDAH DIATASI di ${title} (${timestamp})!\n\nStatus Sabun dan Tisu kembali normal.\n`;
+        message = `✅MASALAH SUDAH DIATASI di ${title} (${timestamp})!\n\nSemua kondisi alert kembali normal.\n`;
         break;
       case 'routine':
-        if (!isAnySoapCritical && !isAnyTissueCritical) {
-          message = `📋 Laporan Rutin Harian dari ${title} (${timestamp}) - Status Aman.\n`;
-        }
+        // Only sent while no rule is firing for the device.
+        message = `📋 Laporan Rutin Harian dari ${title} (${timestamp}) - Status Aman.\n`;
         break;
       default:
         break;
@@ -1949,9 +2374,12 @@ async function bootstrap(): Promise<void> {
     const storedConfig = await configRepository.get();
     config = deriveConfig(storedConfig ?? DEFAULT_CONFIG_BASE);
 
+    activeExperiment = await experimentRepository.findActive();
+    alertRuleEngine.setRules(await alertRuleRepository.list());
+
     const storedSettings = await deviceSettingsRepository.list();
     Object.entries(storedSettings).forEach(([deviceId, sensorConfig]) => {
-      deviceSensorSettings[deviceId] = normalizeSensorConfig(sensorConfig);
+      deviceSensorSettings.set(deviceId, sensorConfig);
     });
 
     const subscribers = await subscriberRepository.list();
@@ -1965,7 +2393,7 @@ async function bootstrap(): Promise<void> {
     const statusUpdates: Promise<void>[] = [];
 
     snapshots.forEach(record => {
-      const snapshot = toLatestDeviceSnapshot(record);
+      const snapshot = toLatestDeviceSnapshot(record, deviceSensorSettings.peek(record.deviceId) ?? DEFAULT_SENSOR_CONFIG);
       if (now - snapshot.lastActive > ESP_INACTIVE_THRESHOLD_MS && snapshot.espStatus !== 'inactive') {
         snapshot.espStatus = 'inactive';
         statusUpdates.push(latestSnapshotRepository.updateStatus(record.deviceId, 'inactive'));
@@ -1981,23 +2409,54 @@ async function bootstrap(): Promise<void> {
     Object.entries(historyTimestamps).forEach(([deviceId, timestamp]) => {
       lastHistoricalSaveTime[deviceId] = timestamp.getTime();
     });
+
+    readRouter.start();
+    eventLoopMonitor.start();
   } catch (error) {
     appLogger.error({ err: error }, 'Bootstrap initialization failed');
     throw error;
   }
 }
 
-function createTelegramBot(token: string | undefined, disablePolling: boolean): TelegramBot | null {
+function createTelegramBot(token: string | undefined): TelegramBot | null {
   if (!token) {
     appLogger.warn('TELEGRAM_BOT_TOKEN tidak disetel. Notifikasi Telegram dinonaktifkan.');
     return null;
   }
 
   try {
-    const bot = new TelegramBot(token, { polling: !disablePolling });
+    const bot = new TelegramBot(token, {
+      polling: appConfig.telegram.updateMode === 'polling',
+      ...(appConfig.telegram.apiBaseUrl ? { baseApiUrl: appConfig.telegram.apiBaseUrl } : {})
+    });
+    appLogger.info({ updateMode: appConfig.telegram.updateMode }, 'Telegram bot initialised');
     return bot;
   } catch (error) {
     appLogger.error({ err: error }, 'Gagal menginisialisasi Telegram bot, notifikasi dinonaktifkan');
     return null;
   }
 }
+
+async function registerTelegramWebhook(): Promise<void> {
+  if (!telegramBot || appConfig.telegram.updateMode !== 'webhook') {
+    return;
+  }
+  if (!appConfig.telegram.webhookUrl) {
+    appLogger.warn('TELEGRAM_WEBHOOK_URL tidak disetel; webhook harus didaftarkan manual ke Bot API.');
+    return;
+  }
+
+  const url = new URL(TELEGRAM_WEBHOOK_PATH, appConfig.telegram.webhookUrl).toString();
+  try {
+    // The library sends these as query parameters, so the list has to be JSON-encoded here.
+    const webhookOptions = {
+      ...(appConfig.telegram.webhookSecret ? { secret_token: appConfig.telegram.webhookSecret } : {}),
+      allowed_updates: JSON.stringify(['message', 'callback_query'])
+    };
+    await telegramBot.setWebHook(url, webhookOptions as unknown as TelegramBot.SetWebHookOptions);
+    appLogger.info({ url }, 'Telegram webhook registered');
+  } catch (error) {
+    appLogger.error({ err: error, url }, 'Failed to register Telegram webhook');
+  }
+}
+
@@ -0,0 +1,137 @@
+import type TelegramBot from 'node-telegram-bot-api';
+import type { Logger } from 'pino';
+
+export interface TelegramUpdateQueueOptions {
+  batchSize: number;
+  batchIntervalMs: number;
+  maxQueuedUpdates: number;
+}
+
+export interface TelegramUpdateQueueStatus {
+  queued: number;
+  received: number;
+  processed: number;
+  duplicates: number;
+  dropped: number;
+  batches: number;
+  maxQueued: number;
+  maxBatchMs: number;
+}
+
+export interface EnqueueResult {
+  accepted: number;
+  duplicates: number;
+  dropped: number;
+}
+
+// Telegram redelivers an update when the webhook response is late or not 2xx.
+const RECENT_UPDATE_IDS = 1024;
+
+/**
+ * Buffers webhook updates and hands them to the bot in small batches on a timer, yielding to
+ * the event loop between batches so a burst of chat traffic cannot hold up device ingestion.
+ * The webhook handler only enqueues and answers immediately: 200, or 429 when updates were
+ * dropped so Telegram delivers them again.
+ */
+export class TelegramUpdateQueue {
+  private queue: TelegramBot.Update[] = [];
+  private recentIds = new Set<number>();
+  private timer: NodeJS.Timeout | null = null;
+  private received = 0;
+  private processed = 0;
+  private duplicates = 0;
+  private dropped = 0;
+  private batches = 0;
+  private maxQueued = 0;
+  private maxBatchMs = 0;
+
+  constructor(
+    private readonly processUpdate: (update: TelegramBot.Update) => void,
+    private readonly options: TelegramUpdateQueueOptions,
+    private readonly logger: Logger
+  ) {}
+
+  enqueue(updates: TelegramBot.Update[]): EnqueueResult {
+    const result: EnqueueResult = { accepted: 0, duplicates: 0, dropped: 0 };
+
+    updates.forEach(update => {
+      this.received += 1;
+      if (this.recentIds.has(update.update_id)) {
+        this.duplicates += 1;
+        result.duplicates += 1;
+        return;
+      }
+      if (this.queue.length >= this.options.maxQueuedUpdates) {
+        this.dropped += 1;
+        result.dropped += 1;
+        return;
+      }
+
+      this.rememberId(update.update_id);
+      this.queue.push(update);
+      result.accepted += 1;
+    });
+
+    if (result.dropped > 0) {
+      this.logger.warn({ dropped: result.dropped, queued: this.queue.length }, 'Telegram update queue full, updates dropped');
+    }
+    this.maxQueued = Math.max(this.maxQueued, this.queue.length);
+    this.schedule();
+    return result;
+  }
+
+  status(): TelegramUpdateQueueStatus {
+    return {
+      queued: this.queue.length,
+      received: this.received,
+      processed: this.processed,
+      duplicates: this.duplicates,
+      dropped: this.dropped,
+      batches: this.batches,
+      maxQueued: this.maxQueued,
+      maxBatchMs: Number(this.maxBatchMs.toFixed(3))
+    };
+  }
+
+  stop(): void {
+    if (this.timer) {
+      clearTimeout(this.timer);
+      this.timer = null;
+    }
+  }
+
+  private schedule(): void {
+    if (this.timer || this.queue.length === 0) {
+      return;
+    }
+    this.timer = setTimeout(() => this.drain(), this.options.batchIntervalMs);
+  }
+
+  private drain(): void {
+    this.timer = null;
+    const batch = this.queue.splice(0, this.options.batchSize);
+    const startedAt = process.hrtime.bigint();
+
+    batch.forEach(update => {
+      try {
+        this.processUpdate(update);
+      } catch (error) {
+        this.logger.error({ err: error, updateId: update.update_id }, 'Failed to process Telegram update');
+      }
+    });
+
+    const elapsedMs = Number(process.hrtime.bigint() - startedAt) / 1e6;
+    this.maxBatchMs = Math.max(this.maxBatchMs, elapsedMs);
+    this.processed += batch.length;
+    this.batches += 1;
+    this.schedule();
+  }
+
+  private rememberId(updateId: number): void {
+    this.recentIds.add(updateId);
+    if (this.recentIds.size > RECENT_UPDATE_IDS) {
+      const oldest = this.recentIds.values().next().value as number;
+      this.recentIds.delete(oldest);
+    }
+  }
+}
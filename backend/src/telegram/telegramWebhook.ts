@@ -0,0 +1,65 @@
+import { timingSafeEqual } from 'node:crypto';
+
+import type { Request, RequestHandler, Response } from 'express';
+import type TelegramBot from 'node-telegram-bot-api';
+
+import type { TelegramUpdateQueue } from './telegramUpdateQueue';
+
+export const TELEGRAM_WEBHOOK_PATH = '/telegram/webhook';
+
+export interface TelegramWebhookOptions {
+  // Value Telegram echoes in X-Telegram-Bot-Api-Secret-Token; null accepts every post.
+  secret: string | null;
+  retryAfterSeconds: number;
+}
+
+export function isValidTelegramWebhookSecret(header: string | undefined, expected: string | null): boolean {
+  if (!expected) {
+    return true;
+  }
+  if (!header) {
+    return false;
+  }
+  const provided = Buffer.from(header);
+  const wanted = Buffer.from(expected);
+  return provided.length === wanted.length && timingSafeEqual(provided, wanted);
+}
+
+export function isTelegramUpdate(value: unknown): value is TelegramBot.Update {
+  return (
+    typeof value === 'object' &&
+    value !== null &&
+    typeof (value as { update_id?: unknown }).update_id === 'number'
+  );
+}
+
+/**
+ * Receives Telegram webhook posts. The secret token is the only authentication: Telegram sends
+ * no Origin header, so the route is exempt from the browser CORS policy.
+ */
+export function createTelegramWebhookHandler(queue: TelegramUpdateQueue, options: TelegramWebhookOptions): RequestHandler {
+  return (req: Request, res: Response) => {
+    if (!isValidTelegramWebhookSecret(req.get('x-telegram-bot-api-secret-token'), options.secret)) {
+      res.status(403).json({ error: 'Invalid webhook secret.' });
+      return;
+    }
+
+    // Telegram posts one update per request; the fake Bot API and replays may post an array.
+    const updates: unknown[] = Array.isArray(req.body) ? req.body : [req.body];
+    const valid = updates.filter(isTelegramUpdate);
+    if (valid.length === 0) {
+      res.status(400).json({ error: 'Invalid Telegram update.' });
+      return;
+    }
+
+    // Dropped updates were not remembered as seen, so answering non-2xx makes Telegram redeliver
+    // them; anything accepted from the same post is skipped as a duplicate on the retry.
+    const result = queue.enqueue(valid);
+    if (result.dropped > 0) {
+      res.set('Retry-After', String(options.retryAfterSeconds));
+      res.status(429).json({ error: 'Telegram update queue is full.' });
+      return;
+    }
+    res.sendStatus(200);
+  };
+}
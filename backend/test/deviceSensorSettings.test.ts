@@ -0,0 +1,57 @@
+import assert from 'node:assert/strict';
+import { test } from 'node:test';
+
+import { DEFAULT_SENSOR_CONFIG, DeviceSensorSettingsCache } from '../src/deviceSensorSettings';
+import type { DeviceSensorConfig } from '../src/repositories/types';
+
+const STORED: DeviceSensorConfig = { ...DEFAULT_SENSOR_CONFIG, sabun2: false, sabun3: false, tisu2: false };
+
+const storedSettings = (settings: Record<string, DeviceSensorConfig>) => {
+  const lookups: string[] = [];
+  return {
+    lookups,
+    source: {
+      get: async (deviceId: string) => {
+        lookups.push(deviceId);
+        return settings[deviceId] ?? null;
+      }
+    }
+  };
+};
+
+// The calls server.ts makes: /data uses get(), /api/history and the settings view use read(),
+// and the device-state sweep uses delete().
+test('stored settings survive eviction followed by a history view', async () => {
+  const { source, lookups } = storedSettings({ 'toilet-lantai-2': STORED });
+  const cache = new DeviceSensorSettingsCache(source);
+
+  assert.deepEqual(await cache.get('toilet-lantai-2'), STORED);
+  cache.delete('toilet-lantai-2');
+
+  assert.deepEqual(await cache.read('toilet-lantai-2'), STORED);
+  assert.equal(cache.has('toilet-lantai-2'), false);
+  assert.equal(cache.size, 0);
+
+  // The device reports again: the stored settings are loaded, not a cached default.
+  assert.deepEqual(await cache.get('toilet-lantai-2'), STORED);
+  assert.deepEqual(lookups, ['toilet-lantai-2', 'toilet-lantai-2', 'toilet-lantai-2']);
+});
+
+test('history views of unknown devices do not grow the cache', async () => {
+  const { source } = storedSettings({});
+  const cache = new DeviceSensorSettingsCache(source);
+
+  for (let i = 0; i < 50; i += 1) {
+    assert.deepEqual(await cache.read(`retired-${i}`), DEFAULT_SENSOR_CONFIG);
+  }
+  assert.equal(cache.size, 0);
+});
+
+test('settings writes are served from the cache and normalized', async () => {
+  const { source, lookups } = storedSettings({});
+  const cache = new DeviceSensorSettingsCache(source);
+
+  cache.set('toilet-lantai-3', { ...DEFAULT_SENSOR_CONFIG, amonia: false, water: 'yes' as unknown as boolean });
+  assert.deepEqual(await cache.get('toilet-lantai-3'), { ...DEFAULT_SENSOR_CONFIG, amonia: false });
+  assert.deepEqual(lookups, []);
+});
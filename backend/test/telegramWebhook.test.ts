@@ -0,0 +1,123 @@
+import assert from 'node:assert/strict';
+import { once } from 'node:events';
+import http from 'node:http';
+import type { AddressInfo } from 'node:net';
+import { after, before, test } from 'node:test';
+
+import express from 'express';
+import pino from 'pino';
+
+import { corsErrorHandler, createCorsMiddleware } from '../src/corsPolicy';
+import { TelegramUpdateQueue } from '../src/telegram/telegramUpdateQueue';
+import { createTelegramWebhookHandler, TELEGRAM_WEBHOOK_PATH } from '../src/telegram/telegramWebhook';
+
+// config.ts reads the environment on import, so it is loaded only after this is set.
+process.env.NODE_ENV = 'production';
+process.env.AUTH_SECRET = 'test-secret';
+process.env.TELEGRAM_UPDATE_MODE = 'webhook';
+process.env.TELEGRAM_WEBHOOK_SECRET = 'webhook-secret';
+process.env.CORS_ALLOWED_ORIGINS_PRODUCTION = 'https://dashboard.example';
+process.env.TELEGRAM_MAX_QUEUED_UPDATES = '2';
+
+const processed: number[] = [];
+let queue: TelegramUpdateQueue;
+let server: http.Server;
+let port = 0;
+
+const post = (path: string, body: unknown, headers: Record<string, string> = {}) =>
+  new Promise<{ status: number; headers: http.IncomingHttpHeaders }>((resolve, reject) => {
+    const payload = JSON.stringify(body);
+    const req = http.request(
+      {
+        method: 'POST',
+        host: '127.0.0.1',
+        port,
+        path,
+        headers: { 'content-type': 'application/json', 'content-length': Buffer.byteLength(payload), ...headers }
+      },
+      res => {
+        res.resume();
+        res.on('end', () => resolve({ status: res.statusCode ?? 0, headers: res.headers }));
+      }
+    );
+    req.on('error', reject);
+    req.end(payload);
+  });
+
+const update = (id: number) => ({ update_id: id, message: { message_id: id, date: 0, chat: { id: 1, type: 'private' } } });
+
+// Mirrors the middleware order in server.ts: CORS, body parsing, routes, CORS error handler.
+before(async () => {
+  const { appConfig, isAllowedOrigin } = await import('../src/config');
+  assert.equal(appConfig.allowRequestsWithoutOrigin, false);
+
+  queue = new TelegramUpdateQueue(
+    item => processed.push(item.update_id),
+    {
+      batchSize: appConfig.telegram.updateBatchSize,
+      // Long enough that a test can fill the queue before it drains.
+      batchIntervalMs: 60_000,
+      maxQueuedUpdates: appConfig.telegram.maxQueuedUpdates
+    },
+    pino({ level: 'silent' })
+  );
+
+  const app = express();
+  const corsMiddleware = createCorsMiddleware({
+    allowRequestsWithoutOrigin: appConfig.allowRequestsWithoutOrigin,
+    isAllowedOrigin,
+    exemptPaths: appConfig.telegram.updateMode === 'webhook' ? [TELEGRAM_WEBHOOK_PATH] : []
+  });
+  app.use(corsMiddleware);
+  app.use(express.json());
+  app.post(TELEGRAM_WEBHOOK_PATH, createTelegramWebhookHandler(queue, { secret: appConfig.telegram.webhookSecret, retryAfterSeconds: 1 }));
+  app.post('/api/other', (_req, res) => {
+    res.sendStatus(200);
+  });
+  app.use(corsErrorHandler);
+
+  server = app.listen(0, '127.0.0.1');
+  await once(server, 'listening');
+  port = (server.address() as AddressInfo).port;
+});
+
+after(() => {
+  queue.stop();
+  server.close();
+});
+
+test('production config still rejects browser routes without an Origin header', async () => {
+  const response = await post('/api/other', {});
+  assert.equal(response.status, 403);
+});
+
+test('webhook accepts a post without an Origin header when the secret matches', async () => {
+  const response = await post(TELEGRAM_WEBHOOK_PATH, update(1), { 'x-telegram-bot-api-secret-token': 'webhook-secret' });
+  assert.equal(response.status, 200);
+  assert.equal(response.headers['access-control-allow-origin'], undefined);
+  assert.equal(queue.status().received, 1);
+});
+
+test('webhook rejects a post without the secret token', async () => {
+  const response = await post(TELEGRAM_WEBHOOK_PATH, update(2));
+  assert.equal(response.status, 403);
+});
+
+test('webhook answers 429 when the queue drops updates and accepts them on redelivery', async () => {
+  const response = await post(TELEGRAM_WEBHOOK_PATH, [update(3), update(4)], {
+    'x-telegram-bot-api-secret-token': 'webhook-secret'
+  });
+  assert.equal(response.status, 429);
+  assert.equal(response.headers['retry-after'], '1');
+  assert.equal(queue.status().dropped, 1);
+
+  // Update 3 was queued and is skipped as a duplicate; update 4 was dropped and still fits once drained.
+  queue['drain']();
+  assert.deepEqual(processed, [1, 3]);
+  const retry = await post(TELEGRAM_WEBHOOK_PATH, [update(3), update(4)], {
+    'x-telegram-bot-api-secret-token': 'webhook-secret'
+  });
+  assert.equal(retry.status, 200);
+  assert.equal(queue.status().duplicates, 1);
+  assert.equal(queue.status().queued, 1);
+});
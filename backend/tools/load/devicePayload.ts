@@ -0,0 +1,21 @@
+/** A /data body shaped like the firmware's buildSensorPayload(), with a random ammonia reading. */
+export const buildDevicePayload = (deviceId: string, sequence: number, boot = 1): string =>
+  JSON.stringify({
+    deviceID: deviceId,
+    amonia: JSON.stringify({ ppm: Number((Math.random() * 5).toFixed(2)) }),
+    waterPuddleJson: JSON.stringify({ digital: 1 }),
+    sabun: JSON.stringify({ sabun1: { distance: 5 }, sabun2: { distance: 6 }, sabun3: { distance: 7 } }),
+    tisu: JSON.stringify({ tisu1: { digital: 1 }, tisu2: { digital: 1 } }),
+    espStatus: 'active',
+    seq: sequence,
+    boot
+  });
+
+/**
+ * The firmware's withSampleAge(): a sample replayed from the pending ring carries how long ago it
+ * was captured, so the server records it in history instead of treating it as a live reading.
+ */
+export const withSampleAge = (payload: string, ageMs: number): string => {
+  const end = payload.lastIndexOf('}');
+  return end < 0 ? payload : `${payload.slice(0, end)},"ageMs":${Math.max(0, Math.round(ageMs))}}`;
+};
@@ -0,0 +1,167 @@
+import { writeFileSync } from 'node:fs';
+import http from 'node:http';
+import https from 'node:https';
+
+import { parseArgs } from '../netem/scenario';
+import { buildDevicePayload } from './devicePayload';
+
+/**
+ * Drives the backend with a whole fleet of devices posting /data at the firmware interval and
+ * collects the server's event-loop lag windows from /readyz while it runs. Run it once per
+ * backend configuration (e.g. TELEGRAM_UPDATE_MODE=polling, webhook, off) and compare the
+ * summaries.
+ */
+
+interface EventLoopLagWindow {
+  windowStart: string;
+  windowMs: number;
+  meanMs: number;
+  p50Ms: number;
+  p99Ms: number;
+  maxMs: number;
+}
+
+interface ReadyzBody {
+  telegramUpdates?: { mode: string; queue: Record<string, number> | null };
+  eventLoop?: { lastWindow: EventLoopLagWindow | null };
+}
+
+const READYZ_POLL_MS = 2000;
+
+const options = parseArgs(process.argv.slice(2));
+if (!options.url) {
+  console.error(
+    'Usage: fleetLoad --url http://127.0.0.1:3000 [--devices 60] [--interval 1000] [--duration 120000]\n' +
+      '                 [--api-key key] [--label polling] [--out report.json]'
+  );
+  process.exit(2);
+}
+
+const baseUrl = new URL(options.url);
+const deviceCount = Math.max(1, Number(options.devices ?? 60));
+const intervalMs = Math.max(50, Number(options.interval ?? 1000));
+const durationMs = Number(options.duration ?? 120_000);
+const apiKey = options['api-key'] ?? process.env.DEVICE_API_KEY ?? '';
+const label = options.label ?? 'run';
+const transport = baseUrl.protocol === 'https:' ? https : http;
+
+const emit = (event: string, payload: Record<string, unknown>): void => {
+  console.log(JSON.stringify({ time: new Date().toISOString(), tool: 'fleetLoad', event, label, ...payload }));
+};
+
+const startedAt = Date.now();
+const latenciesMs: number[] = [];
+const failures: Record<string, number> = {};
+const lagWindows = new Map<string, EventLoopLagWindow>();
+let sent = 0;
+let delivered = 0;
+let lastReadyz: ReadyzBody | null = null;
+
+const request = (method: 'GET' | 'POST', path: string, body?: string) =>
+  new Promise<{ status: number; body: string }>((resolve, reject) => {
+    const req = transport.request(
+      {
+        method,
+        hostname: baseUrl.hostname,
+        port: baseUrl.port,
+        path,
+        agent: false,
+        headers: body
+          ? { 'content-type': 'application/json', 'content-length': Buffer.byteLength(body), 'x-api-key': apiKey }
+          : {}
+      },
+      res => {
+        const chunks: Buffer[] = [];
+        res.on('data', chunk => chunks.push(chunk as Buffer));
+        res.on('end', () => resolve({ status: res.statusCode ?? 0, body: Buffer.concat(chunks).toString('utf8') }));
+      }
+    );
+    req.setTimeout(15_000, () => req.destroy(new Error('timeout')));
+    req.on('error', reject);
+    req.end(body);
+  });
+
+const runDevice = async (index: number): Promise<void> => {
+  const deviceId = `load-${String(index + 1).padStart(3, '0')}`;
+  let sequence = 0;
+  // Spread the fleet over one interval instead of firing every device in the same tick.
+  await new Promise(resolve => setTimeout(resolve, (intervalMs * index) / deviceCount));
+
+  while (Date.now() - startedAt < durationMs) {
+    const cycleStart = Date.now();
+    sequence += 1;
+    sent += 1;
+    try {
+      const result = await request('POST', '/data', buildDevicePayload(deviceId, sequence));
+      if (result.status >= 200 && result.status < 300) {
+        delivered += 1;
+        latenciesMs.push(Date.now() - cycleStart);
+      } else {
+        failures[`http-${result.status}`] = (failures[`http-${result.status}`] ?? 0) + 1;
+      }
+    } catch (error) {
+      const kind = error instanceof Error ? error.message : 'error';
+      failures[kind] = (failures[kind] ?? 0) + 1;
+    }
+    await new Promise(resolve => setTimeout(resolve, Math.max(0, intervalMs - (Date.now() - cycleStart))));
+  }
+};
+
+const pollReadyz = async (): Promise<void> => {
+  try {
+    const result = await request('GET', '/readyz');
+    lastReadyz = JSON.parse(result.body) as ReadyzBody;
+    const window = lastReadyz.eventLoop?.lastWindow;
+    // Only windows that started after the fleet was running describe the loaded server.
+    if (window && Date.parse(window.windowStart) >= startedAt + intervalMs) {
+      lagWindows.set(window.windowStart, window);
+    }
+  } catch (error) {
+    emit('readyz-error', { message: error instanceof Error ? error.message : String(error) });
+  }
+};
+
+const percentile = (values: number[], fraction: number): number | null => {
+  if (values.length === 0) {
+    return null;
+  }
+  const sorted = [...values].sort((a, b) => a - b);
+  return sorted[Math.min(sorted.length - 1, Math.floor(fraction * sorted.length))];
+};
+
+const main = async (): Promise<void> => {
+  emit('start', { url: baseUrl.origin, devices: deviceCount, intervalMs, durationMs });
+  const poller = setInterval(() => void pollReadyz(), READYZ_POLL_MS);
+
+  await Promise.all(Array.from({ length: deviceCount }, (_, index) => runDevice(index)));
+  clearInterval(poller);
+  await pollReadyz();
+
+  const windows = Array.from(lagWindows.values());
+  const summary = {
+    devices: deviceCount,
+    intervalMs,
+    durationMs: Date.now() - startedAt,
+    sent,
+    delivered,
+    failures,
+    latencyMs: { p50: percentile(latenciesMs, 0.5), p95: percentile(latenciesMs, 0.95), max: percentile(latenciesMs, 1) },
+    telegramUpdates: lastReadyz?.telegramUpdates ?? null,
+    eventLoopLag: {
+      windows: windows.length,
+      meanMs: windows.length ? Number((windows.reduce((sum, w) => sum + w.meanMs, 0) / windows.length).toFixed(3)) : null,
+      worstP99Ms: windows.length ? Math.max(...windows.map(w => w.p99Ms)) : null,
+      maxMs: windows.length ? Math.max(...windows.map(w => w.maxMs)) : null
+    }
+  };
+
+  emit('summary', summary);
+  if (options.out) {
+    writeFileSync(options.out, JSON.stringify({ label, ...summary }, null, 2));
+  }
+};
+
+main().catch(error => {
+  console.error(error);
+  process.exit(1);
+});
@@ -0,0 +1,354 @@
+import { promises as dnsPromises } from 'node:dns';
+import { readFileSync, writeFileSync } from 'node:fs';
+import https from 'node:https';
+import type { LookupFunction } from 'node:net';
+
+import { buildDevicePayload, withSampleAge } from '../load/devicePayload';
+import { loadScenario, parseArgs, resolveStartTime, ScenarioTimeline } from './scenario';
+
+/**
+ * Replays the firmware uplink loop (kirimDataKeServer in main.ino) against the fault proxy so
+ * retry, buffering and recovery behaviour can be measured without hardware:
+ * one TLS connection per POST, pending samples flushed oldest-first with one attempt each,
+ * then the fresh sample with maxSendAttempts and 1s/2s/4s backoff, and a fixed-size pending
+ * ring that drops its oldest entry when full. Replayed samples carry ageMs like the firmware's.
+ */
+
+type FailureKind = 'dns' | 'reset' | 'timeout' | 'refused' | 'http' | 'other';
+
+interface PhaseReport {
+  phase: string;
+  generated: number;
+  delivered: number;
+  deliveredFromPending: number;
+  attempts: number;
+  failures: Record<FailureKind, number>;
+  dropped: number;
+  maxPending: number;
+  latenciesMs: number[];
+  startedAt: number;
+  endedAt: number;
+}
+
+interface PendingSample {
+  payload: string;
+  capturedAt: number;
+}
+
+interface RecoveryRecord {
+  afterPhase: string;
+  linkRestoredAt: string;
+  firstSuccessMs: number | null;
+  backlogDrainedMs: number | null;
+}
+
+const options = parseArgs(process.argv.slice(2));
+if (!options.scenario || !options.url) {
+  console.error(
+    'Usage: deviceSim --scenario <file> --url https://host:8443/data [--device-id sim-1] [--api-key key]\n' +
+      '                 [--dns 127.0.0.1:5353] [--ca cert.pem | --insecure] [--start <epoch-ms|ISO>]\n' +
+      '                 [--duration <ms>] [--out report.json]'
+  );
+  process.exit(2);
+}
+
+const scenario = loadScenario(options.scenario);
+const profile = scenario.device;
+const timeline = new ScenarioTimeline(scenario, resolveStartTime(options.start));
+const endpoint = new URL(options.url);
+const deviceId = options['device-id'] ?? 'sim-1';
+const apiKey = options['api-key'] ?? process.env.DEVICE_API_KEY ?? '';
+const runUntil = options.duration ? Date.now() + Number(options.duration) : Infinity;
+
+const emit = (event: string, payload: Record<string, unknown>): void => {
+  console.log(JSON.stringify({ time: new Date().toISOString(), tool: 'deviceSim', event, ...payload }));
+};
+
+// Resolve through the fault proxy's DNS responder so dnsFailure phases reach the simulator too.
+let lookup: LookupFunction | undefined;
+if (options.dns) {
+  const resolver = new dnsPromises.Resolver({ timeout: 2000, tries: 2 });
+  resolver.setServers([options.dns]);
+  lookup = (hostname, lookupOptions, callback) => {
+    resolver
+      .resolve4(hostname)
+      .then(addresses => {
+        if ((lookupOptions as { all?: boolean }).all) {
+          (callback as unknown as (err: null, addresses: { address: string; family: number }[]) => void)(
+            null,
+            addresses.map(address => ({ address, family: 4 }))
+          );
+        } else {
+          callback(null, addresses[0], 4);
+        }
+      })
+      .catch(error => callback(error as NodeJS.ErrnoException, '', 4));
+  };
+}
+
+const ca = options.ca ? readFileSync(options.ca) : undefined;
+const rejectUnauthorized = options.insecure !== 'true';
+
+const newReport = (phase: string): PhaseReport => ({
+  phase,
+  generated: 0,
+  delivered: 0,
+  deliveredFromPending: 0,
+  attempts: 0,
+  failures: { dns: 0, reset: 0, timeout: 0, refused: 0, http: 0, other: 0 },
+  dropped: 0,
+  maxPending: 0,
+  latenciesMs: [],
+  startedAt: Date.now(),
+  endedAt: 0
+});
+
+const reports: PhaseReport[] = [];
+const recoveries: RecoveryRecord[] = [];
+let report = newReport(timeline.at().phase.name);
+let phaseIndex = timeline.at().index;
+let openRecovery: { record: RecoveryRecord; restoredAt: number } | null = null;
+
+const pending: PendingSample[] = [];
+let sequence = 0;
+
+const classify = (error: NodeJS.ErrnoException): FailureKind => {
+  switch (error.code) {
+    case 'ENOTFOUND':
+    case 'EAI_AGAIN':
+    case 'ESERVFAIL':
+    case 'ETIMEOUT':
+      return 'dns';
+    case 'ECONNRESET':
+    case 'EPIPE':
+      return 'reset';
+    case 'ETIMEDOUT':
+      return 'timeout';
+    case 'ECONNREFUSED':
+      return 'refused';
+    default:
+      return 'other';
+  }
+};
+
+const post = (payload: string): Promise<{ ok: true; latencyMs: number } | { ok: false; kind: FailureKind }> =>
+  new Promise(resolve => {
+    const startedAt = Date.now();
+    let settled = false;
+    const settle = (result: { ok: true; latencyMs: number } | { ok: false; kind: FailureKind }) => {
+      if (!settled) {
+        settled = true;
+        resolve(result);
+      }
+    };
+
+    const request = https.request(
+      endpoint,
+      {
+        method: 'POST',
+        agent: false,
+        lookup,
+        ca,
+        rejectUnauthorized,
+        headers: {
+          'Content-Type': 'application/json',
+          'Content-Length': Buffer.byteLength(payload),
+          'X-API-Key': apiKey
+        }
+      },
+      response => {
+        response.resume();
+        response.on('end', () => {
+          const status = response.statusCode ?? 0;
+          settle(status >= 200 && status < 300 ? { ok: true, latencyMs: Date.now() - startedAt } : { ok: false, kind: 'http' });
+        });
+      }
+    );
+
+    // Same budget as WiFiClientSecure::setTimeout: the whole exchange, not just idle time.
+    const timer = setTimeout(() => {
+      request.destroy(Object.assign(new Error('uplink timeout'), { code: 'ETIMEDOUT' }));
+    }, profile.tlsTimeoutMs);
+    request.on('close', () => clearTimeout(timer));
+    request.on('error', error => settle({ ok: false, kind: classify(error as NodeJS.ErrnoException) }));
+    request.end(payload);
+  });
+
+const sleep = (ms: number) => new Promise(resolve => setTimeout(resolve, ms));
+
+const recordAttempt = (result: Awaited<ReturnType<typeof post>>, fromPending: boolean): void => {
+  report.attempts += 1;
+  if (!result.ok) {
+    report.failures[result.kind] += 1;
+    return;
+  }
+
+  report.delivered += 1;
+  if (fromPending) {
+    report.deliveredFromPending += 1;
+  }
+  report.latenciesMs.push(result.latencyMs);
+
+  if (openRecovery && openRecovery.record.firstSuccessMs === null) {
+    openRecovery.record.firstSuccessMs = Date.now() - openRecovery.restoredAt;
+  }
+};
+
+const pushPending = (sample: PendingSample): void => {
+  if (profile.pendingSlots === 0) {
+    report.dropped += 1;
+    return;
+  }
+  if (pending.length === profile.pendingSlots) {
+    pending.shift();
+    report.dropped += 1;
+  }
+  pending.push(sample);
+  report.maxPending = Math.max(report.maxPending, pending.length);
+};
+
+const sendCycle = async (): Promise<void> => {
+  while (pending.length > 0) {
+    const result = await post(withSampleAge(pending[0].payload, Date.now() - pending[0].capturedAt));
+    recordAttempt(result, true);
+    if (!result.ok) {
+      break;
+    }
+    pending.shift();
+  }
+
+  const capturedAt = Date.now();
+  sequence += 1;
+  const payload = buildDevicePayload(deviceId, sequence);
+  report.generated += 1;
+
+  for (let attempt = 1; attempt <= profile.maxSendAttempts; attempt += 1) {
+    const result = await post(payload);
+    recordAttempt(result, false);
+    if (result.ok) {
+      break;
+    }
+    if (attempt === profile.maxSendAttempts) {
+      pushPending({ payload, capturedAt });
+    } else {
+      await sleep(1000 * 2 ** (attempt - 1));
+    }
+  }
+
+  if (openRecovery && openRecovery.record.firstSuccessMs !== null && pending.length === 0) {
+    openRecovery.record.backlogDrainedMs = Date.now() - openRecovery.restoredAt;
+    openRecovery = null;
+  }
+};
+
+const percentile = (values: number[], fraction: number): number | null => {
+  if (values.length === 0) {
+    return null;
+  }
+  const sorted = [...values].sort((a, b) => a - b);
+  return sorted[Math.min(sorted.length - 1, Math.floor(fraction * sorted.length))];
+};
+
+const summarize = (entry: PhaseReport) => {
+  const durationS = Math.max(1, (entry.endedAt || Date.now()) - entry.startedAt) / 1000;
+  return {
+    phase: entry.phase,
+    durationS: Number(durationS.toFixed(1)),
+    generated: entry.generated,
+    delivered: entry.delivered,
+    deliveredFromPending: entry.deliveredFromPending,
+    deliveredPerMin: Number(((entry.delivered / durationS) * 60).toFixed(2)),
+    attempts: entry.attempts,
+    failures: entry.failures,
+    dropped: entry.dropped,
+    maxPending: entry.maxPending,
+    latencyMs: {
+      p50: percentile(entry.latenciesMs, 0.5),
+      p95: percentile(entry.latenciesMs, 0.95),
+      max: percentile(entry.latenciesMs, 1)
+    }
+  };
+};
+
+// Called between cycles; a cycle that straddles a boundary is counted in the phase it started in.
+const rollPhase = (): void => {
+  const state = timeline.at();
+  if (state.index === phaseIndex && !state.finished) {
+    return;
+  }
+
+  const previous = scenario.phases[phaseIndex];
+  report.endedAt = Date.now();
+  reports.push(report);
+  emit('phase-report', summarize(report));
+
+  if ((previous.outage || previous.dnsFailure) && !state.phase.outage && !state.phase.dnsFailure) {
+    const record: RecoveryRecord = {
+      afterPhase: previous.name,
+      linkRestoredAt: new Date().toISOString(),
+      firstSuccessMs: null,
+      backlogDrainedMs: null
+    };
+    recoveries.push(record);
+    openRecovery = { record, restoredAt: Date.now() };
+  }
+
+  phaseIndex = state.index;
+  report = newReport(state.phase.name);
+};
+
+const main = async (): Promise<void> => {
+  emit('start', { scenario: scenario.name, url: endpoint.href, deviceId, profile });
+
+  let lastCycleAt = 0;
+  while (Date.now() < runUntil && !timeline.at().finished) {
+    const waitMs = lastCycleAt + profile.webUpdateIntervalMs - Date.now();
+    if (waitMs > 0) {
+      await sleep(Math.min(waitMs, 100));
+      rollPhase();
+      continue;
+    }
+
+    lastCycleAt = Date.now();
+    await sendCycle();
+    rollPhase();
+  }
+
+  report.endedAt = Date.now();
+  reports.push(report);
+  emit('phase-report', summarize(report));
+
+  const summary = {
+    scenario: scenario.name,
+    deviceId,
+    profile,
+    totals: summarize(
+      reports.reduce((total, entry) => {
+        total.generated += entry.generated;
+        total.delivered += entry.delivered;
+        total.deliveredFromPending += entry.deliveredFromPending;
+        total.attempts += entry.attempts;
+        total.dropped += entry.dropped;
+        total.maxPending = Math.max(total.maxPending, entry.maxPending);
+        total.latenciesMs.push(...entry.latenciesMs);
+        (Object.keys(entry.failures) as FailureKind[]).forEach(kind => {
+          total.failures[kind] += entry.failures[kind];
+        });
+        return total;
+      }, Object.assign(newReport('total'), { startedAt: reports[0]?.startedAt ?? Date.now(), endedAt: Date.now() }))
+    ),
+    stillPending: pending.length,
+    phases: reports.map(summarize),
+    recoveries
+  };
+
+  emit('summary', summary);
+  if (options.out) {
+    writeFileSync(options.out, `${JSON.stringify(summary, null, 2)}\n`);
+  }
+};
+
+main().catch(error => {
+  console.error(error);
+  process.exit(1);
+});
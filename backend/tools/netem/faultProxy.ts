@@ -0,0 +1,319 @@
+import dgram from 'node:dgram';
+import { readFileSync } from 'node:fs';
+import net, { AddressInfo, Socket } from 'node:net';
+import tls from 'node:tls';
+
+import { loadScenario, parseArgs, resolveStartTime, ScenarioTimeline } from './scenario';
+
+/**
+ * Scriptable network impairment between a device (ESP32 or deviceSim.ts) and the backend.
+ *
+ *   device --TLS--> [faultProxy :8443] --TCP--> upstream (backend TLS edge, or the built-in
+ *                                                 TLS terminator in front of a local :3000)
+ *
+ * Impairments are applied to the raw TCP stream, so TLS handshakes see the same latency, stalls
+ * and resets a device would on a bad Wi-Fi link. A small DNS responder answers every A query
+ * with this host so a real device can keep its production hostname (and certificate check).
+ */
+
+interface PhaseStats {
+  phase: string;
+  connections: number;
+  resets: number;
+  stalledConnects: number;
+  lossDelays: number;
+  bytesUp: number;
+  bytesDown: number;
+  dnsQueries: number;
+  dnsFailures: number;
+}
+
+const QUEUE_HIGH_WATER = 64;
+const QUEUE_LOW_WATER = 16;
+const RESET_MIN_BYTES = 64;
+const RESET_MAX_BYTES = 4096;
+const STATS_POLL_MS = 250;
+
+const options = parseArgs(process.argv.slice(2));
+if (!options.scenario) {
+  console.error(
+    'Usage: faultProxy --scenario <file> [--listen 8443] [--upstream host:port] [--tls-cert file --tls-key file]\n' +
+      '                  [--dns-port 5353] [--dns-answer 127.0.0.1] [--start <epoch-ms|ISO>]'
+  );
+  process.exit(2);
+}
+
+const scenario = loadScenario(options.scenario);
+const timeline = new ScenarioTimeline(scenario, resolveStartTime(options.start));
+const listenPort = Number(options.listen ?? 8443);
+const dnsPort = Number(options['dns-port'] ?? 5353);
+const dnsAnswer = (options['dns-answer'] ?? '127.0.0.1').split('.').map(Number);
+
+const newStats = (phase: string): PhaseStats => ({
+  phase,
+  connections: 0,
+  resets: 0,
+  stalledConnects: 0,
+  lossDelays: 0,
+  bytesUp: 0,
+  bytesDown: 0,
+  dnsQueries: 0,
+  dnsFailures: 0
+});
+
+let currentPhaseIndex = timeline.at().index;
+let stats = newStats(timeline.at().phase.name);
+
+const emit = (event: string, payload: Record<string, unknown>): void => {
+  console.log(JSON.stringify({ time: new Date().toISOString(), tool: 'faultProxy', event, ...payload }));
+};
+
+const parseHostPort = (value: string, defaultHost: string): { host: string; port: number } => {
+  const separator = value.lastIndexOf(':');
+  if (separator === -1) {
+    return { host: defaultHost, port: Number(value) };
+  }
+  return { host: value.slice(0, separator) || defaultHost, port: Number(value.slice(separator + 1)) };
+};
+
+/** Forwards one direction of a connection, delaying each chunk according to the current phase. */
+class ImpairedLink {
+  private lastDeliveryAt = 0;
+  private bandwidthFreeAt = 0;
+  private queued = 0;
+
+  constructor(
+    private readonly from: Socket,
+    private readonly to: Socket,
+    private readonly direction: 'up' | 'down'
+  ) {
+    from.on('data', chunk => this.push(chunk as Buffer));
+    from.on('end', () => this.schedule(() => to.end()));
+  }
+
+  private push(chunk: Buffer): void {
+    const now = Date.now();
+    const { phase } = timeline.at(now);
+
+    let deliverAt = now + phase.latencyMs + (phase.jitterMs > 0 ? (Math.random() * 2 - 1) * phase.jitterMs : 0);
+    if (phase.lossRate > 0 && Math.random() < phase.lossRate) {
+      deliverAt += phase.retransmitTimeoutMs;
+      stats.lossDelays += 1;
+    }
+    if (phase.bandwidthBytesPerSec > 0) {
+      const sendStart = Math.max(now, this.bandwidthFreeAt);
+      this.bandwidthFreeAt = sendStart + (chunk.length * 1000) / phase.bandwidthBytesPerSec;
+      deliverAt = Math.max(deliverAt, this.bandwidthFreeAt + phase.latencyMs);
+    }
+
+    if (this.direction === 'up') {
+      stats.bytesUp += chunk.length;
+    } else {
+      stats.bytesDown += chunk.length;
+    }
+
+    this.queued += 1;
+    if (this.queued >= QUEUE_HIGH_WATER) {
+      this.from.pause();
+    }
+    this.schedule(() => {
+      this.queued -= 1;
+      if (!this.to.destroyed) {
+        this.to.write(chunk);
+      }
+      if (this.queued <= QUEUE_LOW_WATER) {
+        this.from.resume();
+      }
+    }, deliverAt);
+  }
+
+  // Chunks never overtake each other and sit out any outage in between.
+  private schedule(deliver: () => void, earliest: number = Date.now()): void {
+    const deliverAt = timeline.nextLinkUpAt(Math.max(earliest, this.lastDeliveryAt));
+    if (!Number.isFinite(deliverAt)) {
+      return;
+    }
+    this.lastDeliveryAt = deliverAt;
+    setTimeout(deliver, Math.max(0, deliverAt - Date.now()));
+  }
+}
+
+const startTlsTerminator = (certFile: string, keyFile: string, backend: { host: string; port: number }) =>
+  new Promise<{ host: string; port: number }>(resolve => {
+    const server = tls.createServer({ cert: readFileSync(certFile), key: readFileSync(keyFile) }, secureSocket => {
+      const upstream = net.connect(backend.port, backend.host);
+      secureSocket.pipe(upstream).pipe(secureSocket);
+      const close = () => {
+        secureSocket.destroy();
+        upstream.destroy();
+      };
+      secureSocket.on('error', close);
+      upstream.on('error', close);
+    });
+    server.listen(0, '127.0.0.1', () => {
+      const address = server.address() as AddressInfo;
+      emit('tls-terminator', { listen: `127.0.0.1:${address.port}`, backend: `${backend.host}:${backend.port}` });
+      resolve({ host: '127.0.0.1', port: address.port });
+    });
+  });
+
+const handleConnection = (client: Socket, upstreamAddress: { host: string; port: number }): void => {
+  const now = Date.now();
+  const { phase } = timeline.at(now);
+  stats.connections += 1;
+  client.setNoDelay(true);
+
+  let resetAfterBytes = Infinity;
+  if (phase.resetRate > 0 && Math.random() < phase.resetRate) {
+    resetAfterBytes = RESET_MIN_BYTES + Math.floor(Math.random() * (RESET_MAX_BYTES - RESET_MIN_BYTES));
+  }
+
+  // During an outage the device's SYN would go unanswered; the closest loopback equivalent is an
+  // accepted socket that stays silent, so handshake timeouts fire exactly as they would on the device.
+  const linkUpAt = timeline.nextLinkUpAt(now);
+  if (linkUpAt > now) {
+    stats.stalledConnects += 1;
+  }
+  if (!Number.isFinite(linkUpAt)) {
+    client.on('error', () => undefined);
+    return;
+  }
+
+  client.pause();
+  setTimeout(() => {
+    if (client.destroyed) {
+      return;
+    }
+
+    const upstream = net.connect({ port: upstreamAddress.port, host: upstreamAddress.host, allowHalfOpen: true });
+    upstream.setNoDelay(true);
+
+    let forwardedUp = 0;
+    client.on('data', chunk => {
+      forwardedUp += (chunk as Buffer).length;
+      if (forwardedUp >= resetAfterBytes && !client.destroyed) {
+        stats.resets += 1;
+        client.resetAndDestroy();
+        upstream.destroy();
+      }
+    });
+
+    new ImpairedLink(client, upstream, 'up');
+    new ImpairedLink(upstream, client, 'down');
+    client.resume();
+
+    // Clean FINs travel through ImpairedLink behind the delayed data; only errors tear down both sides.
+    const close = () => {
+      client.destroy();
+      upstream.destroy();
+    };
+    client.on('error', close);
+    upstream.on('error', close);
+  }, linkUpAt - now);
+};
+
+const startDnsResponder = (): void => {
+  const socket = dgram.createSocket('udp4');
+
+  socket.on('message', (query, remote) => {
+    if (query.length < 12) {
+      return;
+    }
+    const { phase } = timeline.at();
+    stats.dnsQueries += 1;
+
+    let offset = 12;
+    while (offset < query.length && query[offset] !== 0) {
+      offset += query[offset] + 1;
+    }
+    const questionEnd = offset + 5;
+    if (questionEnd > query.length) {
+      return;
+    }
+    const qtype = query.readUInt16BE(offset + 1);
+
+    if (phase.dnsFailure || phase.outage) {
+      stats.dnsFailures += 1;
+      if (phase.dnsMode === 'drop' || phase.outage) {
+        return;
+      }
+    }
+
+    const failing = phase.dnsFailure;
+    const answerA = !failing && qtype === 1;
+    const header = Buffer.alloc(12);
+    header.writeUInt16BE(query.readUInt16BE(0), 0);
+    header.writeUInt16BE(failing ? 0x8182 : 0x8180, 2); // response, RD+RA, rcode SERVFAIL/NOERROR
+    header.writeUInt16BE(1, 4);
+    header.writeUInt16BE(answerA ? 1 : 0, 6);
+
+    const parts = [header, query.subarray(12, questionEnd)];
+    if (answerA) {
+      const answer = Buffer.alloc(16);
+      answer.writeUInt16BE(0xc00c, 0); // pointer to the question name
+      answer.writeUInt16BE(1, 2); // A
+      answer.writeUInt16BE(1, 4); // IN
+      answer.writeUInt32BE(5, 6); // short TTL so devices re-resolve across phases
+      answer.writeUInt16BE(4, 10);
+      dnsAnswer.forEach((octet, index) => answer.writeUInt8(octet, 12 + index));
+      parts.push(answer);
+    }
+    socket.send(Buffer.concat(parts), remote.port, remote.address);
+  });
+
+  socket.bind(dnsPort, () => emit('dns', { listen: dnsPort, answer: dnsAnswer.join('.') }));
+};
+
+const flushStats = (): void => {
+  emit('phase-stats', { ...stats });
+};
+
+const main = async (): Promise<void> => {
+  const backend = parseHostPort(options.upstream ?? '127.0.0.1:3000', '127.0.0.1');
+  const upstreamAddress =
+    options['tls-cert'] && options['tls-key']
+      ? await startTlsTerminator(options['tls-cert'], options['tls-key'], backend)
+      : backend;
+
+  const server = net.createServer({ allowHalfOpen: true }, client => handleConnection(client, upstreamAddress));
+  server.listen(listenPort, () =>
+    emit('listening', {
+      listen: listenPort,
+      upstream: `${upstreamAddress.host}:${upstreamAddress.port}`,
+      scenario: scenario.name,
+      start: new Date(timeline.startedAt).toISOString()
+    })
+  );
+
+  if (dnsPort > 0) {
+    startDnsResponder();
+  }
+
+  const initial = timeline.at();
+  emit('phase', { index: initial.index, ...initial.phase });
+
+  const poll = setInterval(() => {
+    const state = timeline.at();
+    if (state.index !== currentPhaseIndex || state.finished) {
+      flushStats();
+      if (state.finished) {
+        clearInterval(poll);
+        emit('scenario-finished', { scenario: scenario.name });
+        return;
+      }
+      currentPhaseIndex = state.index;
+      stats = newStats(state.phase.name);
+      emit('phase', { index: state.index, ...state.phase });
+    }
+  }, STATS_POLL_MS);
+
+  process.on('SIGINT', () => {
+    flushStats();
+    process.exit(0);
+  });
+};
+
+main().catch(error => {
+  console.error(error);
+  process.exit(1);
+});
@@ -0,0 +1,156 @@
+import { readFileSync } from 'node:fs';
+import path from 'node:path';
+import { z } from 'zod';
+
+const phaseSchema = z
+  .object({
+    name: z.string().min(1),
+    durationMs: z.number().int().positive(),
+    // One-way delay added to every chunk in both directions.
+    latencyMs: z.number().nonnegative().default(0),
+    jitterMs: z.number().nonnegative().default(0),
+    // TCP never loses bytes, so a "lost" chunk is delivered after a retransmission timeout instead.
+    lossRate: z.number().min(0).max(1).default(0),
+    retransmitTimeoutMs: z.number().int().positive().default(300),
+    // Per-direction cap; 0 means unlimited.
+    bandwidthBytesPerSec: z.number().int().nonnegative().default(0),
+    // Probability that a new connection is reset part-way through the request.
+    resetRate: z.number().min(0).max(1).default(0),
+    // DNS queries answer SERVFAIL (or time out when dnsMode is "drop").
+    dnsFailure: z.boolean().default(false),
+    dnsMode: z.enum(['servfail', 'drop']).default('servfail'),
+    // Link down: new connections get no response and open ones stall until the phase ends.
+    outage: z.boolean().default(false)
+  })
+  .strict();
+
+const deviceSchema = z
+  .object({
+    webUpdateIntervalMs: z.number().int().positive().default(1000),
+    maxSendAttempts: z.number().int().min(1).default(3),
+    tlsTimeoutMs: z.number().int().positive().default(15000),
+    pendingSlots: z.number().int().nonnegative().default(4)
+  })
+  .strict();
+
+const scenarioSchema = z
+  .object({
+    name: z.string().min(1),
+    description: z.string().optional(),
+    loop: z.boolean().default(false),
+    device: deviceSchema.default({}),
+    phases: z.array(phaseSchema).min(1)
+  })
+  .strict();
+
+export type ScenarioPhase = z.infer<typeof phaseSchema>;
+export type DeviceProfile = z.infer<typeof deviceSchema>;
+export type Scenario = z.infer<typeof scenarioSchema>;
+
+export interface PhaseState {
+  index: number;
+  phase: ScenarioPhase;
+  // Absolute epoch ms at which the current phase ends (Infinity once a non-looping scenario is over).
+  endsAt: number;
+  finished: boolean;
+}
+
+export const loadScenario = (file: string): Scenario => {
+  const raw = JSON.parse(readFileSync(path.resolve(file), 'utf8')) as unknown;
+  const result = scenarioSchema.safeParse(raw);
+  if (!result.success) {
+    throw new Error(`Invalid scenario ${file}: ${JSON.stringify(result.error.flatten().fieldErrors)}`);
+  }
+  return result.data;
+};
+
+export const scenarioDurationMs = (scenario: Scenario): number =>
+  scenario.phases.reduce((total, phase) => total + phase.durationMs, 0);
+
+/**
+ * Maps wall-clock time onto the scenario phases. Both the fault proxy and the device simulator
+ * build one from the same file and start time, so their phase boundaries line up.
+ */
+export class ScenarioTimeline {
+  private readonly totalMs: number;
+
+  constructor(
+    readonly scenario: Scenario,
+    readonly startedAt: number = Date.now()
+  ) {
+    this.totalMs = scenarioDurationMs(scenario);
+  }
+
+  at(now: number = Date.now()): PhaseState {
+    let elapsed = Math.max(0, now - this.startedAt);
+    let cycleStart = this.startedAt;
+
+    if (elapsed >= this.totalMs) {
+      if (!this.scenario.loop) {
+        const last = this.scenario.phases.length - 1;
+        return { index: last, phase: this.scenario.phases[last], endsAt: Infinity, finished: true };
+      }
+      const cycles = Math.floor(elapsed / this.totalMs);
+      cycleStart += cycles * this.totalMs;
+      elapsed -= cycles * this.totalMs;
+    }
+
+    let phaseStart = cycleStart;
+    for (let index = 0; index < this.scenario.phases.length; index += 1) {
+      const phase = this.scenario.phases[index];
+      if (elapsed < phase.durationMs) {
+        return { index, phase, endsAt: phaseStart + phase.durationMs, finished: false };
+      }
+      elapsed -= phase.durationMs;
+      phaseStart += phase.durationMs;
+    }
+
+    // Unreachable: elapsed < totalMs guarantees a match above.
+    const last = this.scenario.phases.length - 1;
+    return { index: last, phase: this.scenario.phases[last], endsAt: phaseStart, finished: false };
+  }
+
+  /** First time at or after `from` when the link is not in an outage phase. */
+  nextLinkUpAt(from: number): number {
+    let state = this.at(from);
+    let cursor = from;
+    for (let guard = 0; state.phase.outage && !state.finished && guard < this.scenario.phases.length * 2; guard += 1) {
+      cursor = state.endsAt;
+      state = this.at(cursor);
+    }
+    return state.phase.outage && state.finished ? Infinity : cursor;
+  }
+}
+
+/**
+ * Parses `--key value` pairs; the tools have too few options to justify a dependency.
+ */
+export const parseArgs = (argv: string[]): Record<string, string> => {
+  const options: Record<string, string> = {};
+  for (let index = 0; index < argv.length; index += 1) {
+    const arg = argv[index];
+    if (!arg.startsWith('--')) {
+      continue;
+    }
+    const next = argv[index + 1];
+    if (next === undefined || next.startsWith('--')) {
+      options[arg.slice(2)] = 'true';
+    } else {
+      options[arg.slice(2)] = next;
+      index += 1;
+    }
+  }
+  return options;
+};
+
+/** Scenario start time shared by both tools, so they can be launched a few seconds apart. */
+export const resolveStartTime = (value: string | undefined): number => {
+  if (!value) {
+    return Date.now();
+  }
+  const parsed = Number.isNaN(Number(value)) ? Date.parse(value) : Number(value);
+  if (!Number.isFinite(parsed)) {
+    throw new Error(`Invalid --start value: ${value}`);
+  }
+  return parsed;
+};
@@ -0,0 +1,298 @@
+import { createWriteStream, readFileSync } from 'node:fs';
+import http from 'node:http';
+
+import WebSocket from 'ws';
+
+/**
+ * Heap snapshots of a backend started with `node --inspect`, taken over the inspector protocol,
+ * and the retained size of named module-level structures computed from them.
+ */
+
+interface InspectorTarget {
+  webSocketDebuggerUrl: string;
+}
+
+interface InspectorReply {
+  id?: number;
+  method?: string;
+  params?: Record<string, unknown>;
+  result?: Record<string, unknown>;
+  error?: { message: string };
+}
+
+const fetchJson = <T>(url: string) =>
+  new Promise<T>((resolve, reject) => {
+    http
+      .get(url, res => {
+        const chunks: Buffer[] = [];
+        res.on('data', chunk => chunks.push(chunk as Buffer));
+        res.on('end', () => {
+          try {
+            resolve(JSON.parse(Buffer.concat(chunks).toString('utf8')) as T);
+          } catch (error) {
+            reject(error);
+          }
+        });
+      })
+      .on('error', reject);
+  });
+
+export class InspectorSession {
+  private nextId = 1;
+  private readonly pending = new Map<number, { resolve: (value: Record<string, unknown>) => void; reject: (error: Error) => void }>();
+  private readonly listeners = new Map<string, (params: Record<string, unknown>) => void>();
+
+  private constructor(private readonly socket: WebSocket) {
+    socket.on('message', data => {
+      const message = JSON.parse(data.toString()) as InspectorReply;
+      if (message.id !== undefined) {
+        const waiter = this.pending.get(message.id);
+        this.pending.delete(message.id);
+        if (message.error) {
+          waiter?.reject(new Error(message.error.message));
+        } else {
+          waiter?.resolve(message.result ?? {});
+        }
+      } else if (message.method) {
+        this.listeners.get(message.method)?.(message.params ?? {});
+      }
+    });
+  }
+
+  /** Attaches to the first target listed by the inspector at e.g. http://127.0.0.1:9229. */
+  static async connect(inspectUrl: string): Promise<InspectorSession> {
+    const targets = await fetchJson<InspectorTarget[]>(new URL('/json/list', inspectUrl).toString());
+    if (targets.length === 0) {
+      throw new Error(`No inspector targets at ${inspectUrl}`);
+    }
+    const socket = new WebSocket(targets[0].webSocketDebuggerUrl, { perMessageDeflate: false, maxPayload: 0 });
+    await new Promise<void>((resolve, reject) => {
+      socket.once('open', () => resolve());
+      socket.once('error', reject);
+    });
+    return new InspectorSession(socket);
+  }
+
+  send(method: string, params: Record<string, unknown> = {}): Promise<Record<string, unknown>> {
+    const id = this.nextId;
+    this.nextId += 1;
+    return new Promise((resolve, reject) => {
+      this.pending.set(id, { resolve, reject });
+      this.socket.send(JSON.stringify({ id, method, params }));
+    });
+  }
+
+  async heapUsage(): Promise<{ usedSize: number; totalSize: number }> {
+    const result = await this.send('Runtime.getHeapUsage');
+    return { usedSize: Number(result.usedSize), totalSize: Number(result.totalSize) };
+  }
+
+  /** Forces a full GC first so the snapshot only holds what is actually retained. */
+  async takeHeapSnapshot(file: string): Promise<void> {
+    const output = createWriteStream(file);
+    this.listeners.set('HeapProfiler.addHeapSnapshotChunk', params => output.write(String(params.chunk)));
+    try {
+      await this.send('HeapProfiler.enable');
+      await this.send('HeapProfiler.collectGarbage');
+      await this.send('HeapProfiler.takeHeapSnapshot', { reportProgress: false });
+    } finally {
+      this.listeners.delete('HeapProfiler.addHeapSnapshotChunk');
+      await new Promise<void>(resolve => output.end(() => resolve()));
+    }
+  }
+
+  close(): void {
+    this.socket.close();
+  }
+}
+
+interface RawHeapSnapshot {
+  snapshot: {
+    meta: {
+      node_fields: string[];
+      node_types: [string[], ...unknown[]];
+      edge_fields: string[];
+      edge_types: [string[], ...unknown[]];
+    };
+  };
+  nodes: number[];
+  edges: number[];
+  strings: string[];
+}
+
+export interface StructureSize {
+  retainedBytes: number | null;
+  matches: number;
+}
+
+export interface HeapSnapshotAnalysis {
+  nodeCount: number;
+  reachableBytes: number;
+  structures: Record<string, StructureSize>;
+}
+
+/**
+ * Computes retained sizes with the iterative dominator algorithm (Cooper, Harvey & Kennedy) over
+ * strong edges from the synthetic root. Structures are found by the name of the context slot
+ * that holds them, i.e. a module-level `const latestData = ...` in server.ts. When a name is
+ * bound in several contexts the largest one is reported.
+ */
+export const analyzeHeapSnapshot = (file: string, structureNames: readonly string[]): HeapSnapshotAnalysis => {
+  const raw = JSON.parse(readFileSync(file, 'utf8')) as RawHeapSnapshot;
+  const { meta } = raw.snapshot;
+  const nodeFieldCount = meta.node_fields.length;
+  const edgeFieldCount = meta.edge_fields.length;
+  const selfSizeOffset = meta.node_fields.indexOf('self_size');
+  const edgeCountOffset = meta.node_fields.indexOf('edge_count');
+  const edgeTypeOffset = meta.edge_fields.indexOf('type');
+  const edgeNameOffset = meta.edge_fields.indexOf('name_or_index');
+  const edgeToOffset = meta.edge_fields.indexOf('to_node');
+  const edgeTypes = meta.edge_types[0];
+  const weakType = edgeTypes.indexOf('weak');
+  const contextType = edgeTypes.indexOf('context');
+
+  const nodes = raw.nodes;
+  const edges = raw.edges;
+  const nodeCount = nodes.length / nodeFieldCount;
+
+  // Outgoing strong edges per node in CSR form, plus the context slots we are looking for.
+  const firstEdge = new Uint32Array(nodeCount + 1);
+  const wanted = new Set(structureNames);
+  const candidates = new Map<string, number[]>();
+  for (let node = 0, edgeIndex = 0; node < nodeCount; node += 1) {
+    firstEdge[node] = edgeIndex;
+    const count = nodes[node * nodeFieldCount + edgeCountOffset];
+    for (let i = 0; i < count; i += 1, edgeIndex += edgeFieldCount) {
+      if (edges[edgeIndex + edgeTypeOffset] === contextType) {
+        const name = raw.strings[edges[edgeIndex + edgeNameOffset]];
+        if (wanted.has(name)) {
+          const target = edges[edgeIndex + edgeToOffset] / nodeFieldCount;
+          candidates.set(name, [...(candidates.get(name) ?? []), target]);
+        }
+      }
+    }
+  }
+  firstEdge[nodeCount] = edges.length;
+
+  const successors = (node: number, visit: (target: number) => void): void => {
+    for (let edgeIndex = firstEdge[node]; edgeIndex < firstEdge[node + 1]; edgeIndex += edgeFieldCount) {
+      if (edges[edgeIndex + edgeTypeOffset] !== weakType) {
+        visit(edges[edgeIndex + edgeToOffset] / nodeFieldCount);
+      }
+    }
+  };
+
+  // Postorder from the root (node 0) with an explicit stack.
+  const UNVISITED = 0xffffffff;
+  const postorderIndex = new Uint32Array(nodeCount).fill(UNVISITED);
+  const postorder = new Uint32Array(nodeCount);
+  const visited = new Uint8Array(nodeCount);
+  const stackNode = new Uint32Array(nodeCount);
+  const stackEdge = new Uint32Array(nodeCount);
+  let reachable = 0;
+  let depth = 0;
+  stackNode[0] = 0;
+  stackEdge[0] = firstEdge[0];
+  visited[0] = 1;
+  while (depth >= 0) {
+    const node = stackNode[depth];
+    let edgeIndex = stackEdge[depth];
+    let descended = false;
+    while (edgeIndex < firstEdge[node + 1]) {
+      const isWeak = edges[edgeIndex + edgeTypeOffset] === weakType;
+      const target = edges[edgeIndex + edgeToOffset] / nodeFieldCount;
+      edgeIndex += edgeFieldCount;
+      if (!isWeak && !visited[target]) {
+        visited[target] = 1;
+        stackEdge[depth] = edgeIndex;
+        depth += 1;
+        stackNode[depth] = target;
+        stackEdge[depth] = firstEdge[target];
+        descended = true;
+        break;
+      }
+    }
+    if (!descended) {
+      postorderIndex[node] = reachable;
+      postorder[reachable] = node;
+      reachable += 1;
+      depth -= 1;
+    }
+  }
+
+  // Predecessors (strong edges between reachable nodes), indexed by postorder number.
+  const predecessorCount = new Uint32Array(reachable + 1);
+  for (let i = 0; i < reachable; i += 1) {
+    successors(postorder[i], target => {
+      if (postorderIndex[target] !== UNVISITED) {
+        predecessorCount[postorderIndex[target] + 1] += 1;
+      }
+    });
+  }
+  for (let i = 1; i <= reachable; i += 1) {
+    predecessorCount[i] += predecessorCount[i - 1];
+  }
+  const predecessors = new Uint32Array(predecessorCount[reachable]);
+  const fill = predecessorCount.slice(0, reachable);
+  for (let i = 0; i < reachable; i += 1) {
+    successors(postorder[i], target => {
+      const targetIndex = postorderIndex[target];
+      if (targetIndex !== UNVISITED) {
+        predecessors[fill[targetIndex]] = i;
+        fill[targetIndex] += 1;
+      }
+    });
+  }
+
+  const rootIndex = reachable - 1;
+  const idom = new Uint32Array(reachable).fill(UNVISITED);
+  idom[rootIndex] = rootIndex;
+  const intersect = (a: number, b: number): number => {
+    while (a !== b) {
+      while (a < b) a = idom[a];
+      while (b < a) b = idom[b];
+    }
+    return a;
+  };
+  let changed = true;
+  while (changed) {
+    changed = false;
+    for (let i = rootIndex - 1; i >= 0; i -= 1) {
+      let candidate = UNVISITED;
+      for (let p = predecessorCount[i]; p < predecessorCount[i + 1]; p += 1) {
+        const predecessor = predecessors[p];
+        if (idom[predecessor] === UNVISITED) {
+          continue;
+        }
+        candidate = candidate === UNVISITED ? predecessor : intersect(predecessor, candidate);
+      }
+      if (candidate !== UNVISITED && idom[i] !== candidate) {
+        idom[i] = candidate;
+        changed = true;
+      }
+    }
+  }
+
+  // Children precede their dominator in postorder, so one pass accumulates retained sizes.
+  const retained = new Float64Array(reachable);
+  let reachableBytes = 0;
+  for (let i = 0; i < reachable; i += 1) {
+    const self = nodes[postorder[i] * nodeFieldCount + selfSizeOffset];
+    retained[i] += self;
+    reachableBytes += self;
+    if (i !== rootIndex && idom[i] !== UNVISITED) {
+      retained[idom[i]] += retained[i];
+    }
+  }
+
+  const structures: Record<string, StructureSize> = {};
+  structureNames.forEach(name => {
+    const sizes = (candidates.get(name) ?? [])
+      .map(node => postorderIndex[node])
+      .filter(index => index !== UNVISITED)
+      .map(index => retained[index]);
+    structures[name] = { retainedBytes: sizes.length ? Math.max(...sizes) : null, matches: sizes.length };
+  });
+
+  return { nodeCount, reachableBytes, structures };
+};
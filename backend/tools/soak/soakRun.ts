@@ -0,0 +1,335 @@
+import { mkdirSync, unlinkSync, writeFileSync } from 'node:fs';
+import http from 'node:http';
+import https from 'node:https';
+import path from 'node:path';
+
+import { buildDevicePayload } from '../load/devicePayload';
+import { parseArgs } from '../netem/scenario';
+import { analyzeHeapSnapshot, InspectorSession } from './heapSnapshot';
+
+/**
+ * Long-running memory soak against a backend started with `node --inspect`. A fleet of simulated
+ * devices posts /data while a fraction of device IDs is retired and replaced on a schedule.
+ * Heap snapshots are taken periodically, and the retained size of every per-device structure in
+ * server.ts is tracked, so growth that outlives the live fleet shows up as a leak.
+ */
+
+// Module-level bindings in server.ts whose size should follow the live fleet, not its history.
+// latestData is the exception: it mirrors the dashboard listing and keeps every device ever seen.
+// websocketClients does not depend on devices and serves as a control.
+const TRACKED_STRUCTURES = [
+  'latestData',
+  'deviceStatuses',
+  'lastHistoricalSaveTime',
+  'deviceSensorSettings',
+  'deviceMuteState',
+  'pendingAlertActions',
+  'deviceAcknowledgements',
+  'alertRuleEngine',
+  'websocketClients'
+] as const;
+
+const FOLLOWS_LISTING = new Set<string>(['latestData']);
+
+interface DeviceSlot {
+  id: string;
+  sequence: number;
+  nextDueAt: number;
+}
+
+interface SnapshotRecord {
+  elapsedMs: number;
+  activeDevices: number;
+  distinctDevices: number;
+  heapUsedBytes: number;
+  reachableBytes: number;
+  structures: Record<string, number | null>;
+  entries: Record<string, number> | null;
+}
+
+const TICK_MS = 100;
+
+const parseDuration = (value: string | undefined, fallback: number): number => {
+  if (!value) {
+    return fallback;
+  }
+  const match = /^(\d+(?:\.\d+)?)(ms|s|m|h|d)?$/.exec(value.trim());
+  if (!match) {
+    throw new Error(`Invalid duration: ${value}`);
+  }
+  const units: Record<string, number> = { ms: 1, s: 1000, m: 60_000, h: 3_600_000, d: 86_400_000 };
+  const unit = units[match[2] ?? 'ms'];
+  return Number(match[1]) * unit;
+};
+
+const options = parseArgs(process.argv.slice(2));
+if (!options.url) {
+  console.error(
+    'Usage: soakRun --url http://127.0.0.1:3000 [--inspect http://127.0.0.1:9229] [--devices 2000]\n' +
+      '               [--interval 30s] [--churn-every 5m] [--churn-fraction 0.05] [--duration 24h]\n' +
+      '               [--snapshot-every 30m] [--concurrency 64] [--api-key key] [--out-dir soak-out]\n' +
+      '               [--leak-slope-bytes-per-hour 1048576] [--keep-snapshots]'
+  );
+  process.exit(2);
+}
+
+const baseUrl = new URL(options.url);
+const inspectUrl = options.inspect ?? 'http://127.0.0.1:9229';
+const deviceCount = Math.max(1, Number(options.devices ?? 2000));
+const intervalMs = parseDuration(options.interval, 30_000);
+const churnEveryMs = parseDuration(options['churn-every'], 5 * 60_000);
+const churnFraction = Math.min(1, Math.max(0, Number(options['churn-fraction'] ?? 0.05)));
+const durationMs = parseDuration(options.duration, 24 * 3_600_000);
+const snapshotEveryMs = parseDuration(options['snapshot-every'], 30 * 60_000);
+const concurrency = Math.max(1, Number(options.concurrency ?? 64));
+const apiKey = options['api-key'] ?? process.env.DEVICE_API_KEY ?? '';
+const outDir = path.resolve(options['out-dir'] ?? 'soak-out');
+const leakSlopeBytesPerHour = Number(options['leak-slope-bytes-per-hour'] ?? 1024 * 1024);
+const keepSnapshots = options['keep-snapshots'] === 'true';
+
+const transport = baseUrl.protocol === 'https:' ? https : http;
+const agent =
+  baseUrl.protocol === 'https:'
+    ? new https.Agent({ keepAlive: true, maxSockets: concurrency })
+    : new http.Agent({ keepAlive: true, maxSockets: concurrency });
+const runId = Date.now().toString(36);
+
+const emit = (event: string, payload: Record<string, unknown>): void => {
+  console.log(JSON.stringify({ time: new Date().toISOString(), tool: 'soakRun', event, ...payload }));
+};
+
+const request = (method: 'GET' | 'POST', requestPath: string, body?: string) =>
+  new Promise<{ status: number; body: string }>((resolve, reject) => {
+    const req = transport.request(
+      {
+        method,
+        hostname: baseUrl.hostname,
+        port: baseUrl.port,
+        path: requestPath,
+        agent,
+        headers: body
+          ? { 'content-type': 'application/json', 'content-length': Buffer.byteLength(body), 'x-api-key': apiKey }
+          : {}
+      },
+      res => {
+        const chunks: Buffer[] = [];
+        res.on('data', chunk => chunks.push(chunk as Buffer));
+        res.on('end', () => resolve({ status: res.statusCode ?? 0, body: Buffer.concat(chunks).toString('utf8') }));
+      }
+    );
+    req.setTimeout(30_000, () => req.destroy(new Error('timeout')));
+    req.on('error', reject);
+    req.end(body);
+  });
+
+const startedAt = Date.now();
+let nextDeviceNumber = 0;
+let distinctDevices = 0;
+let inFlight = 0;
+const counters = { sent: 0, delivered: 0, failed: 0, retired: 0, added: 0 };
+const failureKinds: Record<string, number> = {};
+
+const newDevice = (now: number): DeviceSlot => {
+  nextDeviceNumber += 1;
+  distinctDevices += 1;
+  return {
+    id: `soak-${runId}-${String(nextDeviceNumber).padStart(6, '0')}`,
+    sequence: 0,
+    nextDueAt: now + Math.random() * intervalMs
+  };
+};
+
+const devices: DeviceSlot[] = Array.from({ length: deviceCount }, () => newDevice(startedAt));
+
+const churn = (now: number): void => {
+  const count = Math.round(devices.length * churnFraction);
+  for (let i = 0; i < count; i += 1) {
+    const index = Math.floor(Math.random() * devices.length);
+    devices[index] = newDevice(now);
+  }
+  counters.retired += count;
+  counters.added += count;
+};
+
+const post = async (device: DeviceSlot): Promise<void> => {
+  inFlight += 1;
+  counters.sent += 1;
+  device.sequence += 1;
+  try {
+    const result = await request('POST', '/data', buildDevicePayload(device.id, device.sequence));
+    if (result.status >= 200 && result.status < 300) {
+      counters.delivered += 1;
+    } else {
+      counters.failed += 1;
+      failureKinds[`http-${result.status}`] = (failureKinds[`http-${result.status}`] ?? 0) + 1;
+    }
+  } catch (error) {
+    counters.failed += 1;
+    const kind = error instanceof Error ? error.message : 'error';
+    failureKinds[kind] = (failureKinds[kind] ?? 0) + 1;
+  } finally {
+    inFlight -= 1;
+  }
+};
+
+// Devices that are due while every slot is busy simply send late, like a slow uplink would.
+const tick = (): void => {
+  const now = Date.now();
+  for (const device of devices) {
+    if (inFlight >= concurrency) {
+      break;
+    }
+    if (device.nextDueAt <= now) {
+      device.nextDueAt = now + intervalMs;
+      void post(device);
+    }
+  }
+};
+
+const readDeviceStateSizes = async (): Promise<Record<string, number> | null> => {
+  try {
+    const result = await request('GET', '/readyz');
+    const body = JSON.parse(result.body) as { deviceState?: { sizes: Record<string, number> } };
+    return body.deviceState?.sizes ?? null;
+  } catch {
+    return null;
+  }
+};
+
+const takeSnapshot = async (session: InspectorSession, index: number): Promise<SnapshotRecord> => {
+  const file = path.join(outDir, `soak-${runId}-${String(index).padStart(3, '0')}.heapsnapshot`);
+  await session.takeHeapSnapshot(file);
+  const usage = await session.heapUsage();
+  const analysis = analyzeHeapSnapshot(file, TRACKED_STRUCTURES);
+  if (!keepSnapshots) {
+    unlinkSync(file);
+  }
+
+  const structures: Record<string, number | null> = {};
+  Object.entries(analysis.structures).forEach(([name, size]) => {
+    structures[name] = size.retainedBytes;
+  });
+
+  return {
+    elapsedMs: Date.now() - startedAt,
+    activeDevices: devices.length,
+    distinctDevices,
+    heapUsedBytes: usage.usedSize,
+    reachableBytes: analysis.reachableBytes,
+    structures,
+    entries: await readDeviceStateSizes()
+  };
+};
+
+// Least-squares slope in bytes per hour.
+const slopePerHour = (points: { x: number; y: number }[]): number | null => {
+  if (points.length < 2) {
+    return null;
+  }
+  const meanX = points.reduce((sum, p) => sum + p.x, 0) / points.length;
+  const meanY = points.reduce((sum, p) => sum + p.y, 0) / points.length;
+  const numerator = points.reduce((sum, p) => sum + (p.x - meanX) * (p.y - meanY), 0);
+  const denominator = points.reduce((sum, p) => sum + (p.x - meanX) ** 2, 0);
+  return denominator === 0 ? null : (numerator / denominator) * 3_600_000;
+};
+
+const buildReport = (snapshots: SnapshotRecord[]) => {
+  // The first half covers warm-up and the fleet filling the maps; leaks show in the second half.
+  const secondHalf = snapshots.slice(Math.floor(snapshots.length / 2));
+  const series = (select: (snapshot: SnapshotRecord) => number | null, from: SnapshotRecord[]) =>
+    from.flatMap(snapshot => {
+      const y = select(snapshot);
+      return y === null ? [] : [{ x: snapshot.elapsedMs, y }];
+    });
+
+  const describe = (select: (snapshot: SnapshotRecord) => number | null, followsListing = false) => {
+    const all = series(select, snapshots);
+    const slope = slopePerHour(series(select, secondHalf));
+    return {
+      firstBytes: all[0]?.y ?? null,
+      lastBytes: all[all.length - 1]?.y ?? null,
+      maxBytes: all.length ? Math.max(...all.map(point => point.y)) : null,
+      growthBytesPerHour: slope === null ? null : Math.round(slope),
+      leakSuspect: !followsListing && slope !== null && slope > leakSlopeBytesPerHour
+    };
+  };
+
+  const structures: Record<string, ReturnType<typeof describe> & { lastEntries: number | null; followsListing: boolean }> = {};
+  TRACKED_STRUCTURES.forEach(name => {
+    const last = snapshots[snapshots.length - 1];
+    const followsListing = FOLLOWS_LISTING.has(name);
+    structures[name] = {
+      ...describe(snapshot => snapshot.structures[name], followsListing),
+      lastEntries: last?.entries?.[name] ?? null,
+      followsListing
+    };
+  });
+
+  return {
+    runId,
+    devices: deviceCount,
+    intervalMs,
+    churnEveryMs,
+    churnFraction,
+    durationMs: Date.now() - startedAt,
+    distinctDevices,
+    requests: { ...counters, failureKinds },
+    leakSlopeBytesPerHour,
+    heapUsed: describe(snapshot => snapshot.heapUsedBytes),
+    structures,
+    snapshots
+  };
+};
+
+const main = async (): Promise<void> => {
+  mkdirSync(outDir, { recursive: true });
+  const session = await InspectorSession.connect(inspectUrl);
+  emit('start', { url: baseUrl.origin, inspectUrl, devices: deviceCount, intervalMs, churnEveryMs, churnFraction, durationMs });
+
+  const snapshots: SnapshotRecord[] = [];
+  const writeReport = () => writeFileSync(path.join(outDir, `soak-${runId}.report.json`), JSON.stringify(buildReport(snapshots), null, 2));
+
+  const ticker = setInterval(tick, TICK_MS);
+  let nextChurnAt = startedAt + churnEveryMs;
+  let nextSnapshotAt = startedAt + snapshotEveryMs;
+  let snapshotIndex = 0;
+
+  const capture = async () => {
+    snapshotIndex += 1;
+    const record = await takeSnapshot(session, snapshotIndex);
+    snapshots.push(record);
+    emit('snapshot', { index: snapshotIndex, ...record, requests: counters });
+    writeReport();
+  };
+
+  await capture();
+  while (Date.now() - startedAt < durationMs) {
+    await new Promise(resolve => setTimeout(resolve, 1000));
+    const now = Date.now();
+    if (now >= nextChurnAt) {
+      churn(now);
+      nextChurnAt += churnEveryMs;
+    }
+    if (now >= nextSnapshotAt) {
+      await capture();
+      nextSnapshotAt += snapshotEveryMs;
+    }
+  }
+
+  clearInterval(ticker);
+  await capture();
+  session.close();
+  agent.destroy();
+
+  const report = buildReport(snapshots);
+  const suspects = Object.entries(report.structures)
+    .filter(([, summary]) => summary.leakSuspect)
+    .map(([name]) => name);
+  emit('summary', { distinctDevices, requests: report.requests, heapUsed: report.heapUsed, suspects });
+  writeReport();
+};
+
+main().catch(error => {
+  console.error(error);
+  process.exit(1);
+});
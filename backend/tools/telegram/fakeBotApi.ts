@@ -0,0 +1,280 @@
+import http, { IncomingMessage, ServerResponse } from 'node:http';
+import { URL } from 'node:url';
+
+import { parseArgs } from '../netem/scenario';
+
+/**
+ * Local stand-in for api.telegram.org so the backend's Telegram modes can be exercised without a
+ * real bot. It generates chat messages at a fixed rate and hands them out through getUpdates
+ * (long polling) or pushes them to the registered webhook, and accepts every outgoing call the
+ * backend makes (sendMessage, answerCallbackQuery, ...).
+ *
+ *   backend --TELEGRAM_API_BASE_URL--> fakeBotApi :8081 --webhook POST--> backend /telegram/webhook
+ */
+
+interface FakeUpdate {
+  update_id: number;
+  message: {
+    message_id: number;
+    date: number;
+    chat: { id: number; type: 'private' };
+    from: { id: number; is_bot: false; first_name: string };
+    text: string;
+  };
+}
+
+interface Waiter {
+  offset: number;
+  respond: (updates: FakeUpdate[]) => void;
+}
+
+const STATS_INTERVAL_MS = 10_000;
+const MAX_BUFFERED_UPDATES = 10_000;
+
+const options = parseArgs(process.argv.slice(2));
+if (options.help) {
+  console.error(
+    'Usage: fakeBotApi [--port 8081] [--rate 5] [--chats 20] [--texts "/status,halo"] [--batch 1]\n' +
+      '                  [--duration <ms>]'
+  );
+  process.exit(2);
+}
+
+const port = Number(options.port ?? 8081);
+const ratePerSec = Number(options.rate ?? 5);
+const chats = Math.max(1, Number(options.chats ?? 20));
+const texts = (options.texts ?? '/status,halo').split(',').map(text => text.trim()).filter(Boolean);
+const webhookBatch = Math.max(1, Number(options.batch ?? 1));
+const runUntil = options.duration ? Date.now() + Number(options.duration) : Infinity;
+
+const emit = (event: string, payload: Record<string, unknown>): void => {
+  console.log(JSON.stringify({ time: new Date().toISOString(), tool: 'fakeBotApi', event, ...payload }));
+};
+
+const newStats = () => ({
+  generated: 0,
+  polled: 0,
+  getUpdatesCalls: 0,
+  webhookPosts: 0,
+  webhookFailures: 0,
+  webhookMaxLatencyMs: 0,
+  outgoing: {} as Record<string, number>
+});
+
+let stats = newStats();
+let nextUpdateId = 1;
+let buffered: FakeUpdate[] = [];
+let webhook: { url: string; secret: string | null } | null = null;
+let webhookPending: FakeUpdate[] = [];
+const waiters = new Set<Waiter>();
+
+const ok = (res: ServerResponse, result: unknown): void => {
+  res.writeHead(200, { 'content-type': 'application/json' });
+  res.end(JSON.stringify({ ok: true, result }));
+};
+
+const fail = (res: ServerResponse, status: number, description: string): void => {
+  res.writeHead(status, { 'content-type': 'application/json' });
+  res.end(JSON.stringify({ ok: false, error_code: status, description }));
+};
+
+// node-telegram-bot-api sends form bodies for most methods and query parameters for setWebHook.
+const readParams = (req: IncomingMessage, url: URL): Promise<Record<string, string>> =>
+  new Promise(resolve => {
+    const chunks: Buffer[] = [];
+    req.on('data', chunk => chunks.push(chunk as Buffer));
+    req.on('end', () => {
+      const params: Record<string, string> = Object.fromEntries(url.searchParams);
+      const body = Buffer.concat(chunks).toString('utf8');
+      if (body.length > 0) {
+        if ((req.headers['content-type'] ?? '').includes('application/json')) {
+          try {
+            Object.entries(JSON.parse(body) as Record<string, unknown>).forEach(([key, value]) => {
+              params[key] = typeof value === 'string' ? value : JSON.stringify(value);
+            });
+          } catch {
+            // Unparseable bodies are treated as empty; the method still answers ok.
+          }
+        } else {
+          Object.assign(params, Object.fromEntries(new URLSearchParams(body)));
+        }
+      }
+      resolve(params);
+    });
+  });
+
+const takeUpdates = (offset: number, limit: number): FakeUpdate[] => {
+  buffered = buffered.filter(update => update.update_id >= offset);
+  return buffered.slice(0, limit);
+};
+
+const handleGetUpdates = (params: Record<string, string>, res: ServerResponse): void => {
+  stats.getUpdatesCalls += 1;
+  const offset = Number(params.offset ?? 0);
+  const limit = Number(params.limit ?? 100);
+  const timeoutMs = Number(params.timeout ?? 0) * 1000;
+
+  const ready = takeUpdates(offset, limit);
+  if (ready.length > 0 || timeoutMs === 0) {
+    stats.polled += ready.length;
+    ok(res, ready);
+    return;
+  }
+
+  const waiter: Waiter = {
+    offset,
+    respond: updates => {
+      waiters.delete(waiter);
+      clearTimeout(timer);
+      stats.polled += updates.length;
+      ok(res, updates);
+    }
+  };
+  const timer = setTimeout(() => waiter.respond([]), timeoutMs);
+  waiters.add(waiter);
+  res.on('close', () => {
+    waiters.delete(waiter);
+    clearTimeout(timer);
+  });
+};
+
+const postToWebhook = (updates: FakeUpdate[]): void => {
+  if (!webhook) {
+    return;
+  }
+  const target = new URL(webhook.url);
+  const body = JSON.stringify(updates.length === 1 ? updates[0] : updates);
+  const startedAt = Date.now();
+  const request = http.request(
+    {
+      method: 'POST',
+      hostname: target.hostname,
+      port: target.port,
+      path: target.pathname,
+      headers: {
+        'content-type': 'application/json',
+        'content-length': Buffer.byteLength(body),
+        ...(webhook.secret ? { 'x-telegram-bot-api-secret-token': webhook.secret } : {})
+      }
+    },
+    response => {
+      response.resume();
+      stats.webhookPosts += 1;
+      stats.webhookMaxLatencyMs = Math.max(stats.webhookMaxLatencyMs, Date.now() - startedAt);
+      if ((response.statusCode ?? 500) >= 300) {
+        stats.webhookFailures += 1;
+      }
+    }
+  );
+  request.on('error', () => {
+    stats.webhookFailures += 1;
+  });
+  request.end(body);
+};
+
+const generateUpdate = (): void => {
+  const chatId = 100_000 + Math.floor(Math.random() * chats);
+  const update: FakeUpdate = {
+    update_id: nextUpdateId,
+    message: {
+      message_id: nextUpdateId,
+      date: Math.floor(Date.now() / 1000),
+      chat: { id: chatId, type: 'private' },
+      from: { id: chatId, is_bot: false, first_name: `Petugas ${chatId}` },
+      text: texts[nextUpdateId % texts.length]
+    }
+  };
+  nextUpdateId += 1;
+  stats.generated += 1;
+
+  if (webhook) {
+    webhookPending.push(update);
+    if (webhookPending.length >= webhookBatch) {
+      postToWebhook(webhookPending);
+      webhookPending = [];
+    }
+    return;
+  }
+
+  buffered.push(update);
+  if (buffered.length > MAX_BUFFERED_UPDATES) {
+    buffered.shift();
+  }
+  waiters.forEach(waiter => {
+    const updates = takeUpdates(waiter.offset, 100);
+    if (updates.length > 0) {
+      waiter.respond(updates);
+    }
+  });
+};
+
+const server = http.createServer(async (req, res) => {
+  const url = new URL(req.url ?? '/', `http://${req.headers.host ?? 'localhost'}`);
+  const match = /^\/bot[^/]+\/(\w+)$/.exec(url.pathname);
+  if (!match) {
+    fail(res, 404, 'Not Found');
+    return;
+  }
+
+  const method = match[1];
+  const params = await readParams(req, url);
+  stats.outgoing[method] = (stats.outgoing[method] ?? 0) + 1;
+
+  switch (method) {
+    case 'getUpdates':
+      handleGetUpdates(params, res);
+      return;
+    case 'setWebHook':
+      webhook = params.url ? { url: params.url, secret: params.secret_token ?? null } : null;
+      emit('webhook', { url: webhook?.url ?? null, secret: Boolean(webhook?.secret) });
+      ok(res, true);
+      return;
+    case 'deleteWebHook':
+      webhook = null;
+      emit('webhook', { url: null });
+      ok(res, true);
+      return;
+    case 'getWebHookInfo':
+      ok(res, { url: webhook?.url ?? '', has_custom_certificate: false, pending_update_count: buffered.length });
+      return;
+    case 'getMe':
+      ok(res, { id: 1, is_bot: true, first_name: 'Fake Bot', username: 'fake_bot' });
+      return;
+    case 'sendMessage':
+      ok(res, {
+        message_id: Date.now(),
+        date: Math.floor(Date.now() / 1000),
+        chat: { id: Number(params.chat_id ?? 0), type: 'private' },
+        text: params.text ?? ''
+      });
+      return;
+    default:
+      ok(res, true);
+  }
+});
+
+server.listen(port, () => emit('listening', { port, ratePerSec, chats, texts, webhookBatch }));
+
+const generator = ratePerSec > 0 ? setInterval(generateUpdate, 1000 / ratePerSec) : null;
+
+const flushStats = (): void => {
+  emit('stats', { ...stats, buffered: buffered.length, mode: webhook ? 'webhook' : 'polling' });
+  stats = newStats();
+};
+
+const statsTimer = setInterval(() => {
+  flushStats();
+  if (Date.now() >= runUntil) {
+    if (generator) {
+      clearInterval(generator);
+    }
+    clearInterval(statsTimer);
+    server.close();
+    process.exit(0);
+  }
+}, STATS_INTERVAL_MS);
+
+process.on('SIGINT', () => {
+  flushStats();
+  process.exit(0);
+});
@@ -1,5 +1,6 @@
 // --- amoniaSensor.cpp ---
 #include "amoniaSensor.h"
+#include "radioActivity.h"
 #include <math.h>
 
 // Definisi variabel Global
@@ -11,6 +12,12 @@ unsigned long lastCalibrationTime = 0;
 float amoniaPPMBuffer = 0.0;
 int bufferCount = 0;
 unsigned long lastAveragingTime = 0;
+unsigned long averagingInterval = 5UL * 60UL * 1000UL;
+
+// Sampel yang terpaksa diambil saat radio aktif
+float amoniaPPMBufferTx = 0.0;
+int bufferCountTx = 0;
+static unsigned long lastAmoniaSampleTime = 0;
 
 void setupAmoniaSensor() {
     pinMode(gasPinLantai1, INPUT);
@@ -75,47 +82,80 @@ float getPPM(float ratio, float a, float b) {
 }
 
 // FUNGSI BARU: Mengumpulkan data ke buffer
+// Dipanggil sesering mungkin; penjadwal di sini yang memilih kapan ADC dibaca.
 void updateAmoniaBuffer() {
     if (sedangKalibrasi) return; // Jangan ambil data saat kalibrasi
-    
-    int adc = analogRead(gasPinLantai1);
+    if (R0 == 0.0) return; 
+
+    unsigned long now = millis();
+    unsigned long sinceLast = now - lastAmoniaSampleTime;
+    if (sinceLast < AMONIA_SAMPLE_INTERVAL_MS) return;
+
+    // Ripple supply saat TX WiFi muncul sebagai lonjakan ppm; tunggu radio sepi
+    bool quiet = radioIsQuiet();
+    if (!quiet && sinceLast < AMONIA_MAX_DEFER_MS) return;
+
+    // Beberapa pembacaan beruntun dalam jendela yang sama untuk meredam noise ADC
+    long adcTotal = 0;
+    for (int i = 0; i < AMONIA_READS_PER_SAMPLE; i++) {
+        adcTotal += analogRead(gasPinLantai1);
+    }
+    float adc = (float)adcTotal / AMONIA_READS_PER_SAMPLE;
+    lastAmoniaSampleTime = now;
+
     float Vout = (adc / 4095.0) * Vcc;
+    if (Vout <= 0.0) return;
     float Rs = ((Vcc - Vout) / Vout) * RL;
     
-    if (R0 == 0.0) return; 
-    
     float ratio = Rs / R0;
     float ppm_NH3 = getPPM(ratio, NH3_Curve[0], NH3_Curve[1]);
     
-    amoniaPPMBuffer += ppm_NH3;
-    bufferCount++;
+    if (quiet) {
+        amoniaPPMBuffer += ppm_NH3;
+        bufferCount++;
+    } else {
+        amoniaPPMBufferTx += ppm_NH3;
+        bufferCountTx++;
+    }
     
     // TIDAK menampilkan status bau di OLED
 }
 
+void getAmoniaSampleCounts(int& cleanSamples, int& txSamples) {
+    cleanSamples = bufferCount;
+    txSamples = bufferCountTx;
+}
+
+// Rata-rata sampel bersih; sampel saat transmit hanya dipakai jika tidak ada yang bersih
+static float currentAveragePPM() {
+    if (bufferCount > 0) {
+        return amoniaPPMBuffer / bufferCount;
+    }
+    if (bufferCountTx > 0) {
+        return amoniaPPMBufferTx / bufferCountTx;
+    }
+    return 0.0;
+}
+
 // FUNGSI BARU: Menghitung rata-rata dari buffer (dipanggil oleh main.ino)
 float getAveragedPPM() {
     unsigned long now = millis();
     float averagedPPM = 0.0;
     
-    if (now - lastAveragingTime >= AVERAGING_INTERVAL) {
-        if (bufferCount > 0) {
-            averagedPPM = amoniaPPMBuffer / bufferCount;
-        }
+    if (now - lastAveragingTime >= averagingInterval) {
+        averagedPPM = currentAveragePPM();
         
         // Reset Buffer
         amoniaPPMBuffer = 0.0;
         bufferCount = 0;
+        amoniaPPMBufferTx = 0.0;
+        bufferCountTx = 0;
         lastAveragingTime = now;
         
         return averagedPPM; 
     }
     
-    if (bufferCount > 0) {
-        return amoniaPPMBuffer / bufferCount;
-    }
-    
-    return 0.0;
+    return currentAveragePPM();
 }
 
 
@@ -24,12 +24,21 @@ const float REG_SLOPE = 1.989;
 // Interval Kalibrasi Tetap
 const unsigned long calibrationInterval = 2UL * 60UL * 60UL * 1000UL;
 
-// Variabel untuk Averaging (5 Menit)
-const unsigned long AVERAGING_INTERVAL = 5UL * 60UL * 1000UL; 
+// Variabel untuk Averaging (default 5 menit, dapat diubah lewat deviceParams)
+extern unsigned long averagingInterval;
 extern float amoniaPPMBuffer;
 extern int bufferCount;
 extern unsigned long lastAveragingTime;
 
+// Penjadwalan ADC: sampel diambil di jendela radio sepi (lihat radioActivity.h).
+// Jika radio terus sibuk, sampel tetap diambil setelah AMONIA_MAX_DEFER_MS dan
+// ditandai "tx" (buffer terpisah, hanya dipakai jika tidak ada sampel bersih).
+const unsigned long AMONIA_SAMPLE_INTERVAL_MS = 200;
+const unsigned long AMONIA_MAX_DEFER_MS = 2000;
+const int AMONIA_READS_PER_SAMPLE = 4;
+extern float amoniaPPMBufferTx;
+extern int bufferCountTx;
+
 // Deklarasi variabel
 extern float R0;
 extern bool sedangKalibrasi;
@@ -42,6 +51,8 @@ void autoKalibrasiAmoniaSensor();
 float getPPM(float ratio, float a, float b);
 void updateAmoniaBuffer(); 
 float getAveragedPPM(); 
+// Jumlah sampel bersih dan sampel saat transmit di jendela averaging berjalan
+void getAmoniaSampleCounts(int& cleanSamples, int& txSamples);
 int konversiKeLikert(float ppm);
 String getAmoniaData();
 
@@ -0,0 +1,163 @@
+// --- deviceParams.cpp ---
+#include "deviceParams.h"
+#include "amoniaSensor.h"
+#include <ArduinoJson.h>
+#include <Preferences.h>
+
+// Nilai default sama dengan DEFAULT_DEVICE_PARAMETERS di backend
+DeviceParams deviceParams = {1000UL, 5UL * 60UL * 1000UL, 3, 15000UL, 15, "default", "default"};
+
+static const char* PARAMS_NAMESPACE = "params";
+
+struct UplinkMetrics {
+    unsigned long windowStart;
+    uint32_t samplesSent;
+    uint32_t samplesMissed;
+    uint32_t retries;
+    uint32_t payloadBytes;
+    uint32_t latencySamples;
+    float totalLatencyMs;
+    float maxLatencyMs;
+    uint32_t minFreeHeap;
+};
+
+static UplinkMetrics metrics = {0, 0, 0, 0, 0, 0, 0.0, 0.0, UINT32_MAX};
+
+static unsigned long clampULong(unsigned long value, unsigned long minValue, unsigned long maxValue) {
+    return value < minValue ? minValue : (value > maxValue ? maxValue : value);
+}
+
+static int clampInt(int value, int minValue, int maxValue) {
+    return value < minValue ? minValue : (value > maxValue ? maxValue : value);
+}
+
+// Batas sama dengan validasi server; dijaga juga di sini agar NVS rusak tidak membuat perangkat macet
+static void clampDeviceParams() {
+    deviceParams.webUpdateIntervalMs = clampULong(deviceParams.webUpdateIntervalMs, 500UL, 60000UL);
+    deviceParams.averagingIntervalMs = clampULong(deviceParams.averagingIntervalMs, 10000UL, 30UL * 60UL * 1000UL);
+    deviceParams.maxSendAttempts = clampInt(deviceParams.maxSendAttempts, 1, 5);
+    deviceParams.tlsTimeoutMs = clampULong(deviceParams.tlsTimeoutMs, 2000UL, 30000UL);
+    deviceParams.tlsHandshakeTimeoutS = clampInt(deviceParams.tlsHandshakeTimeoutS, 2, 30);
+}
+
+static void applyToSensors() {
+    averagingInterval = deviceParams.averagingIntervalMs;
+}
+
+void loadDeviceParams() {
+    Preferences prefs;
+    if (prefs.begin(PARAMS_NAMESPACE, true)) {
+        deviceParams.webUpdateIntervalMs = prefs.getULong("webMs", deviceParams.webUpdateIntervalMs);
+        deviceParams.averagingIntervalMs = prefs.getULong("avgMs", deviceParams.averagingIntervalMs);
+        deviceParams.maxSendAttempts = prefs.getInt("attempts", deviceParams.maxSendAttempts);
+        deviceParams.tlsTimeoutMs = prefs.getULong("tlsMs", deviceParams.tlsTimeoutMs);
+        deviceParams.tlsHandshakeTimeoutS = prefs.getInt("tlsHsS", deviceParams.tlsHandshakeTimeoutS);
+        prefs.getString("cohort", deviceParams.cohort, sizeof(deviceParams.cohort));
+        prefs.getString("version", deviceParams.paramsVersion, sizeof(deviceParams.paramsVersion));
+        prefs.end();
+    }
+
+    clampDeviceParams();
+    applyToSensors();
+    Serial.printf("[PARAM] Cohort %s (%s): kirim %lums, averaging %lums, %d percobaan, TLS %lums/%ds\n",
+                  deviceParams.cohort, deviceParams.paramsVersion, deviceParams.webUpdateIntervalMs,
+                  deviceParams.averagingIntervalMs, deviceParams.maxSendAttempts, deviceParams.tlsTimeoutMs,
+                  deviceParams.tlsHandshakeTimeoutS);
+}
+
+static void saveDeviceParams() {
+    Preferences prefs;
+    if (!prefs.begin(PARAMS_NAMESPACE, false)) {
+        Serial.println("[PARAM] Gagal membuka NVS untuk menyimpan parameter.");
+        return;
+    }
+    prefs.putULong("webMs", deviceParams.webUpdateIntervalMs);
+    prefs.putULong("avgMs", deviceParams.averagingIntervalMs);
+    prefs.putInt("attempts", deviceParams.maxSendAttempts);
+    prefs.putULong("tlsMs", deviceParams.tlsTimeoutMs);
+    prefs.putInt("tlsHsS", deviceParams.tlsHandshakeTimeoutS);
+    prefs.putString("cohort", deviceParams.cohort);
+    prefs.putString("version", deviceParams.paramsVersion);
+    prefs.end();
+}
+
+bool applyDeviceParamsJson(const String& json) {
+    StaticJsonDocument<512> doc;
+    DeserializationError error = deserializeJson(doc, json);
+    if (error) {
+        Serial.printf("[PARAM] Respons parameter tidak valid: %s\n", error.c_str());
+        return false;
+    }
+
+    const char* version = doc["paramsVersion"] | "default";
+    if (strcmp(version, deviceParams.paramsVersion) == 0) {
+        return false;
+    }
+
+    JsonObject params = doc["parameters"];
+    deviceParams.webUpdateIntervalMs = params["webUpdateIntervalMs"] | deviceParams.webUpdateIntervalMs;
+    deviceParams.averagingIntervalMs = params["averagingIntervalMs"] | deviceParams.averagingIntervalMs;
+    deviceParams.maxSendAttempts = params["maxSendAttempts"] | deviceParams.maxSendAttempts;
+    deviceParams.tlsTimeoutMs = params["tlsTimeoutMs"] | deviceParams.tlsTimeoutMs;
+    deviceParams.tlsHandshakeTimeoutS = params["tlsHandshakeTimeoutS"] | deviceParams.tlsHandshakeTimeoutS;
+    strlcpy(deviceParams.cohort, doc["cohort"] | "default", sizeof(deviceParams.cohort));
+    strlcpy(deviceParams.paramsVersion, version, sizeof(deviceParams.paramsVersion));
+
+    clampDeviceParams();
+    applyToSensors();
+    saveDeviceParams();
+    Serial.printf("[PARAM] Parameter baru diterapkan: cohort %s (%s)\n", deviceParams.cohort, deviceParams.paramsVersion);
+    return true;
+}
+
+void metricsRecordSend(bool success, unsigned long latencyMs, size_t payloadBytes) {
+    metrics.payloadBytes += payloadBytes;
+    if (!success) {
+        return;
+    }
+    metrics.samplesSent++;
+    metrics.latencySamples++;
+    metrics.totalLatencyMs += latencyMs;
+    if (latencyMs > metrics.maxLatencyMs) {
+        metrics.maxLatencyMs = latencyMs;
+    }
+}
+
+void metricsRecordRetry() {
+    metrics.retries++;
+}
+
+void metricsRecordMissed() {
+    metrics.samplesMissed++;
+}
+
+void metricsSampleHeap() {
+    uint32_t freeHeap = ESP.getFreeHeap();
+    if (freeHeap < metrics.minFreeHeap) {
+        metrics.minFreeHeap = freeHeap;
+    }
+}
+
+String buildMetricsReport(unsigned long now) {
+    metricsSampleHeap();
+
+    StaticJsonDocument<384> doc;
+    doc["cohort"] = deviceParams.cohort;
+    doc["paramsVersion"] = deviceParams.paramsVersion;
+    doc["windowMs"] = now - metrics.windowStart;
+    doc["samplesSent"] = metrics.samplesSent;
+    doc["samplesMissed"] = metrics.samplesMissed;
+    doc["retries"] = metrics.retries;
+    doc["payloadBytes"] = metrics.payloadBytes;
+    doc["avgUplinkLatencyMs"] = metrics.latencySamples > 0 ? metrics.totalLatencyMs / metrics.latencySamples : 0.0;
+    doc["maxUplinkLatencyMs"] = metrics.maxLatencyMs;
+    doc["minFreeHeap"] = metrics.minFreeHeap;
+
+    String json;
+    serializeJson(doc, json);
+    return json;
+}
+
+void metricsReset(unsigned long now) {
+    metrics = {now, 0, 0, 0, 0, 0, 0.0, 0.0, UINT32_MAX};
+}
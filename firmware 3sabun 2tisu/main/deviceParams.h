@@ -0,0 +1,43 @@
+// --- deviceParams.h ---
+#ifndef DEVICE_PARAMS_H
+#define DEVICE_PARAMS_H
+
+#include <Arduino.h>
+
+// Parameter runtime yang bisa diatur server per cohort eksperimen.
+// Disimpan di NVS agar tetap dipakai setelah power-on tanpa menunggu server.
+struct DeviceParams {
+    unsigned long webUpdateIntervalMs;
+    unsigned long averagingIntervalMs;
+    int maxSendAttempts;
+    unsigned long tlsTimeoutMs;
+    int tlsHandshakeTimeoutS;
+    char cohort[33];
+    char paramsVersion[81];
+};
+
+extern DeviceParams deviceParams;
+
+// Interval sinkron parameter dan kirim laporan metrik
+const unsigned long PARAMS_REFRESH_INTERVAL = 15UL * 60UL * 1000UL;
+// Sebelum fetch pertama berhasil: jeda coba ulang berlipat dua tiap gagal (1, 2, 4 ... menit)
+// hingga PARAMS_REFRESH_INTERVAL
+const unsigned long PARAMS_RETRY_MIN_INTERVAL = 30UL * 1000UL;
+const unsigned long METRICS_REPORT_INTERVAL = 5UL * 60UL * 1000UL;
+
+// Muat parameter dari NVS (atau default) lalu terapkan ke variabel sensor
+void loadDeviceParams();
+// Parsing respons GET /device/<id>/parameters; nilai di-clamp ke batas aman.
+// Mengembalikan true jika versi parameter berubah.
+bool applyDeviceParamsJson(const String& json);
+
+// Metrik uplink per jendela laporan
+void metricsRecordSend(bool success, unsigned long latencyMs, size_t payloadBytes);
+void metricsRecordRetry();
+void metricsRecordMissed();
+void metricsSampleHeap();
+// Bangun payload POST /device/<id>/metrics untuk jendela berjalan
+String buildMetricsReport(unsigned long now);
+void metricsReset(unsigned long now);
+
+#endif
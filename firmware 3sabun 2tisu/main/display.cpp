@@ -7,6 +7,9 @@ Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1);
 // Variabel status global untuk layar (internal file ini)
 static String currentStatus = "Memulai...";
 
+// Halaman yang sedang ada di layar; -1 berarti layar dipakai fungsi lain
+static int shownPage = -1;
+
 void setupDisplay() {
     // KONEKSI I2C KHUSUS: Wire.begin(SDA, SCL);
     Wire.begin(OLED_SDA, OLED_SCL); 
@@ -24,6 +27,7 @@ void setupDisplay() {
 void displayStatus(String status) {
     if (status != currentStatus) {
         currentStatus = status;
+        shownPage = -1;
         
         display.clearDisplay();
         display.setTextColor(SSD1306_WHITE);
@@ -39,40 +43,17 @@ void displayStatus(String status) {
 }
 
 // FUNGSI RUNNING STATUS (Digunakan untuk mode Online Normal)
+// Sekarang hanya memperbarui identitas; isi layar diurus tampilan berhalaman
 void displayRunningStatus(String ipAddress, String deviceID) {
-    // Fungsi ini tidak menggunakan currentStatus check
-    
-    display.clearDisplay();
-    display.setTextColor(SSD1306_WHITE);
-
-    // Baris 1: Device ID
-    display.setTextSize(1); 
-    display.setCursor(0, 0);
-    display.print("ID: ");
-    display.println(deviceID);
-    
-    // Baris 2: IP Address
-    display.setCursor(0, 10);
-    display.print("IP: ");
-    display.println(ipAddress);
-    
-    // Garis Pemisah
-    display.drawFastHLine(0, 22, SCREEN_WIDTH, SSD1306_WHITE);
-
-    // Baris 3 & 4 (Pesan Ringkas/Online Status)
-    display.setTextSize(2); 
-    display.setCursor(0, 30);
-    display.println("ONLINE &"); 
-    
-    display.setCursor(0, 48);
-    display.println("BERJALAN");
-    
-    display.display();
+    statusSetIdentity(ipAddress, deviceID);
+    displayStatusPages();
 }
 
 
 // FUNGSI BARU: Menampilkan status Access Point (Portal Setup)
 void displayPortalStatus(String apName, String apIP) {
+    shownPage = -1;
+    currentStatus = "";
     display.clearDisplay();
     display.setTextColor(SSD1306_WHITE);
 
@@ -98,4 +79,427 @@ void displayPortalStatus(String apName, String apIP) {
     display.println("Akses 192.168.4.1");
 
     display.display();
-}
\ No newline at end of file
+}
+
+
+// === Tampilan Status Berhalaman ===
+
+// Kanvas 1-bit dengan tata letak memori persis seperti SSD1306 (8 baris piksel per byte),
+// sehingga menampilkan halaman cukup memcpy ke buffer display.
+class PageBuffer : public Adafruit_GFX {
+public:
+    PageBuffer() : Adafruit_GFX(SCREEN_WIDTH, SCREEN_HEIGHT) {
+        memset(buffer, 0, sizeof(buffer));
+    }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override {
+        if (x < 0 || y < 0 || x >= SCREEN_WIDTH || y >= SCREEN_HEIGHT) {
+            return;
+        }
+        uint8_t* cell = &buffer[x + (y / 8) * SCREEN_WIDTH];
+        if (color) {
+            *cell |= (1 << (y & 7));
+        } else {
+            *cell &= ~(1 << (y & 7));
+        }
+    }
+
+    void fillScreen(uint16_t color) override {
+        memset(buffer, color ? 0xFF : 0x00, sizeof(buffer));
+    }
+
+    uint8_t buffer[SCREEN_WIDTH * SCREEN_HEIGHT / 8];
+};
+
+// Nilai yang ditampilkan, sudah dibulatkan sesuai presisi layar
+struct StatusValues {
+    String ip;
+    String deviceID;
+    int ppmTenths = -1;        // ppm x 10; -1 = belum ada data
+    int skor = 0;
+    int cleanSamples = 0;
+    int txSamples = 0;
+    long soap[3] = {-1, -1, -1};
+    int tisu[2] = {-1, -1};
+    int air = -1;
+    bool connected = false;
+    int rssi = 0;
+    int pending = 0;
+    bool lastUplinkOk = true;
+    unsigned long uptimeMin = 0;
+};
+
+static const char* const PAGE_TITLES[STATUS_PAGE_COUNT] = {
+    "RINGKAS", "AMONIA", "SABUN", "TISU & AIR", "JARINGAN"
+};
+
+// Batas jarak sabun habis, sama dengan default SOAP_EMPTY_THRESHOLD di backend
+const long DISPLAY_SOAP_EMPTY_CM = 10;
+
+static PageBuffer pageBuffers[STATUS_PAGE_COUNT];
+static uint32_t pageRevision[STATUS_PAGE_COUNT] = {0};
+static uint32_t shownRevision = 0;
+static uint8_t dirtyPages = (1 << STATUS_PAGE_COUNT) - 1;
+static StatusValues values;
+
+static int currentPage = PAGE_RINGKAS;
+static unsigned long lastPageChange = 0;
+static unsigned long lastButtonPress = 0;
+static bool manualSelection = false;
+
+static DisplayFrameStats frameStats = {0};
+static unsigned long lastStatsPrint = 0;
+
+static inline void markDirty(uint8_t pageMask) {
+    dirtyPages |= pageMask;
+}
+
+#define PAGE_BIT(page) (1 << (page))
+
+static const char* soapLabel(long distance) {
+    if (distance < 0) return "--";
+    return distance > DISPLAY_SOAP_EMPTY_CM ? "Habis" : "Aman";
+}
+
+static const char* tissueLabel(int digital) {
+    if (digital < 0) return "--";
+    return digital == 0 ? "Habis" : "Tersedia";
+}
+
+static const char* waterLabel(int digital) {
+    if (digital < 0) return "--";
+    return digital == LOW ? "Genangan" : "Kering";
+}
+
+static const char* amoniaLabel(int skor) {
+    if (skor == 1) return "Bagus";
+    if (skor == 2) return "Normal";
+    if (skor == 3) return "Kritis";
+    return "--";
+}
+
+static void printPpm(PageBuffer& page, int ppmTenths) {
+    if (ppmTenths < 0) {
+        page.print("--");
+        return;
+    }
+    page.print(ppmTenths / 10);
+    page.print('.');
+    page.print(ppmTenths % 10);
+}
+
+// --- Setter ---
+
+void statusSetIdentity(const String& ipAddress, const String& deviceID) {
+    if (ipAddress != values.ip) {
+        values.ip = ipAddress;
+        markDirty(PAGE_BIT(PAGE_JARINGAN));
+    }
+    if (deviceID != values.deviceID) {
+        values.deviceID = deviceID;
+        markDirty(PAGE_BIT(PAGE_RINGKAS) | PAGE_BIT(PAGE_JARINGAN));
+    }
+}
+
+void statusSetAmonia(float ppm, int skor, int cleanSamples, int txSamples) {
+    int ppmTenths = (ppm < 0 || isnan(ppm)) ? -1 : (int)(ppm * 10.0f + 0.5f);
+    if (ppmTenths != values.ppmTenths || skor != values.skor) {
+        values.ppmTenths = ppmTenths;
+        values.skor = skor;
+        markDirty(PAGE_BIT(PAGE_RINGKAS) | PAGE_BIT(PAGE_AMONIA));
+    }
+    if (cleanSamples != values.cleanSamples || txSamples != values.txSamples) {
+        values.cleanSamples = cleanSamples;
+        values.txSamples = txSamples;
+        markDirty(PAGE_BIT(PAGE_AMONIA));
+    }
+}
+
+void statusSetSoap(long distance1, long distance2, long distance3) {
+    long distances[3] = {distance1, distance2, distance3};
+    bool changed = false;
+    bool labelChanged = false;
+    for (int i = 0; i < 3; i++) {
+        if (distances[i] != values.soap[i]) {
+            if (strcmp(soapLabel(distances[i]), soapLabel(values.soap[i])) != 0) {
+                labelChanged = true;
+            }
+            values.soap[i] = distances[i];
+            changed = true;
+        }
+    }
+    if (changed) {
+        // Halaman ringkas hanya menampilkan status, bukan jarak
+        markDirty(PAGE_BIT(PAGE_SABUN) | (labelChanged ? PAGE_BIT(PAGE_RINGKAS) : 0));
+    }
+}
+
+void statusSetTissueWater(int tisu1, int tisu2, int air) {
+    if (tisu1 != values.tisu[0] || tisu2 != values.tisu[1] || air != values.air) {
+        values.tisu[0] = tisu1;
+        values.tisu[1] = tisu2;
+        values.air = air;
+        markDirty(PAGE_BIT(PAGE_RINGKAS) | PAGE_BIT(PAGE_TISU_AIR));
+    }
+}
+
+void statusSetLink(bool connected, int rssi, int pendingSamples, bool lastUplinkOk) {
+    unsigned long uptimeMin = millis() / 60000UL;
+    if (connected != values.connected || rssi != values.rssi || pendingSamples != values.pending ||
+        lastUplinkOk != values.lastUplinkOk || uptimeMin != values.uptimeMin) {
+        values.connected = connected;
+        values.rssi = rssi;
+        values.pending = pendingSamples;
+        values.lastUplinkOk = lastUplinkOk;
+        values.uptimeMin = uptimeMin;
+        markDirty(PAGE_BIT(PAGE_JARINGAN));
+    }
+}
+
+// --- Render ke buffer off-screen ---
+
+static void renderHeader(PageBuffer& page, int index) {
+    page.setTextSize(1);
+    page.setCursor(0, 0);
+    page.print(PAGE_TITLES[index]);
+    page.setCursor(SCREEN_WIDTH - 18, 0);
+    page.print(index + 1);
+    page.print('/');
+    page.print((int)STATUS_PAGE_COUNT);
+    page.drawFastHLine(0, 10, SCREEN_WIDTH, SSD1306_WHITE);
+}
+
+static void renderRingkas(PageBuffer& page) {
+    page.setCursor(0, 14);
+    page.print("ID: ");
+    page.print(values.deviceID);
+
+    page.setCursor(0, 26);
+    page.print("NH3: ");
+    printPpm(page, values.ppmTenths);
+    page.print(" ppm ");
+    page.print(amoniaLabel(values.skor));
+
+    int soapEmpty = 0;
+    for (int i = 0; i < 3; i++) {
+        if (values.soap[i] > DISPLAY_SOAP_EMPTY_CM) soapEmpty++;
+    }
+    int tissueEmpty = (values.tisu[0] == 0) + (values.tisu[1] == 0);
+
+    page.setCursor(0, 38);
+    page.print("Sabun habis: ");
+    page.print(soapEmpty);
+    page.print("/3");
+
+    page.setCursor(0, 48);
+    page.print("Tisu habis: ");
+    page.print(tissueEmpty);
+    page.print("/2");
+
+    page.setCursor(0, 56);
+    page.print("Air: ");
+    page.print(waterLabel(values.air));
+}
+
+static void renderAmonia(PageBuffer& page) {
+    page.setTextSize(3);
+    page.setCursor(0, 16);
+    printPpm(page, values.ppmTenths);
+    page.setTextSize(1);
+    page.setCursor(page.getCursorX(), 30);
+    page.print(" ppm");
+
+    page.setCursor(0, 44);
+    page.print("Status: ");
+    page.print(amoniaLabel(values.skor));
+
+    page.setCursor(0, 56);
+    page.print("Sampel: ");
+    page.print(values.cleanSamples);
+    page.print(" (+");
+    page.print(values.txSamples);
+    page.print(" tx)");
+}
+
+static void renderSabun(PageBuffer& page) {
+    for (int i = 0; i < 3; i++) {
+        page.setCursor(0, 16 + i * 16);
+        page.print("Sabun ");
+        page.print(i + 1);
+        page.print(": ");
+        if (values.soap[i] < 0) {
+            page.print("-- cm");
+        } else {
+            page.print(values.soap[i]);
+            page.print(" cm");
+        }
+        page.setCursor(96, 16 + i * 16);
+        page.print(soapLabel(values.soap[i]));
+    }
+}
+
+static void renderTisuAir(PageBuffer& page) {
+    for (int i = 0; i < 2; i++) {
+        page.setCursor(0, 18 + i * 14);
+        page.print("Tisu ");
+        page.print(i + 1);
+        page.print(": ");
+        page.print(tissueLabel(values.tisu[i]));
+    }
+    page.setCursor(0, 50);
+    page.print("Lantai: ");
+    page.print(waterLabel(values.air));
+}
+
+static void renderJaringan(PageBuffer& page) {
+    page.setCursor(0, 14);
+    page.print("IP: ");
+    page.print(values.ip);
+
+    page.setCursor(0, 25);
+    page.print("WiFi: ");
+    if (values.connected) {
+        page.print(values.rssi);
+        page.print(" dBm");
+    } else {
+        page.print("terputus");
+    }
+
+    page.setCursor(0, 36);
+    page.print("Kirim: ");
+    page.print(values.lastUplinkOk ? "OK" : "GAGAL");
+    page.print(" Antre ");
+    page.print(values.pending);
+
+    page.setCursor(0, 47);
+    page.print("Uptime: ");
+    page.print(values.uptimeMin / 60);
+    page.print("j ");
+    page.print(values.uptimeMin % 60);
+    page.print("m");
+
+    page.setCursor(0, 56);
+    page.print("ID: ");
+    page.print(values.deviceID);
+}
+
+static void renderPage(int index) {
+    unsigned long startUs = micros();
+    PageBuffer& page = pageBuffers[index];
+
+    page.fillScreen(SSD1306_BLACK);
+    page.setTextColor(SSD1306_WHITE);
+    page.setTextWrap(false);
+    renderHeader(page, index);
+
+    switch (index) {
+        case PAGE_RINGKAS:   renderRingkas(page); break;
+        case PAGE_AMONIA:    renderAmonia(page); break;
+        case PAGE_SABUN:     renderSabun(page); break;
+        case PAGE_TISU_AIR:  renderTisuAir(page); break;
+        case PAGE_JARINGAN:  renderJaringan(page); break;
+    }
+
+    dirtyPages &= ~PAGE_BIT(index);
+    pageRevision[index]++;
+
+    uint32_t elapsed = micros() - startUs;
+    frameStats.renders++;
+    frameStats.renderUsTotal += elapsed;
+    if (elapsed > frameStats.renderUsMax) frameStats.renderUsMax = elapsed;
+}
+
+// --- Pergantian halaman & frame ---
+
+static void showPage(int index) {
+    currentPage = index;
+    lastPageChange = millis();
+}
+
+void displayNextPage() {
+    lastButtonPress = millis();
+    manualSelection = true;
+    showPage((currentPage + 1) % STATUS_PAGE_COUNT);
+}
+
+static void printFrameStats(unsigned long now) {
+    if (now - lastStatsPrint < DISPLAY_STATS_INTERVAL_MS) {
+        return;
+    }
+    lastStatsPrint = now;
+    if (frameStats.frames == 0) {
+        return;
+    }
+
+    Serial.printf("[OLED] frame=%lu idle=%lu render=%lu (avg %lu us, max %lu us) flush=%lu (avg %lu us, max %lu us) frame avg %lu us, max %lu us\n",
+                  (unsigned long)frameStats.frames,
+                  (unsigned long)frameStats.idleFrames,
+                  (unsigned long)frameStats.renders,
+                  (unsigned long)(frameStats.renders ? frameStats.renderUsTotal / frameStats.renders : 0),
+                  (unsigned long)frameStats.renderUsMax,
+                  (unsigned long)frameStats.flushes,
+                  (unsigned long)(frameStats.flushes ? frameStats.flushUsTotal / frameStats.flushes : 0),
+                  (unsigned long)frameStats.flushUsMax,
+                  (unsigned long)(frameStats.frameUsTotal / frameStats.frames),
+                  (unsigned long)frameStats.frameUsMax);
+    frameStats = DisplayFrameStats{0};
+}
+
+void displayStatusPages() {
+    unsigned long frameStartUs = micros();
+    unsigned long now = millis();
+    uint32_t rendersBefore = frameStats.renders;
+
+    if (manualSelection && now - lastButtonPress >= PAGE_MANUAL_HOLD_MS) {
+        manualSelection = false;
+        lastPageChange = now;
+    }
+    if (!manualSelection && now - lastPageChange >= PAGE_ROTATE_MS) {
+        showPage((currentPage + 1) % STATUS_PAGE_COUNT);
+    }
+
+    // Maksimal satu render per frame: halaman aktif dulu, lalu satu halaman latar
+    // agar perpindahan berikutnya cukup menyalin buffer.
+    if (dirtyPages & PAGE_BIT(currentPage)) {
+        renderPage(currentPage);
+    } else if (dirtyPages) {
+        for (int i = 1; i < STATUS_PAGE_COUNT; i++) {
+            int index = (currentPage + i) % STATUS_PAGE_COUNT;
+            if (dirtyPages & PAGE_BIT(index)) {
+                renderPage(index);
+                break;
+            }
+        }
+    }
+
+    bool flushed = false;
+    if (shownPage != currentPage || shownRevision != pageRevision[currentPage]) {
+        unsigned long flushStartUs = micros();
+        memcpy(display.getBuffer(), pageBuffers[currentPage].buffer, sizeof(pageBuffers[currentPage].buffer));
+        display.display();
+        shownPage = currentPage;
+        shownRevision = pageRevision[currentPage];
+        // Layar tidak lagi menampilkan pesan displayStatus(); pesan yang sama harus digambar ulang
+        currentStatus = "";
+        flushed = true;
+
+        uint32_t elapsed = micros() - flushStartUs;
+        frameStats.flushes++;
+        frameStats.flushUsTotal += elapsed;
+        if (elapsed > frameStats.flushUsMax) frameStats.flushUsMax = elapsed;
+    }
+
+    uint32_t frameUs = micros() - frameStartUs;
+    frameStats.frames++;
+    frameStats.frameUsTotal += frameUs;
+    if (frameUs > frameStats.frameUsMax) frameStats.frameUsMax = frameUs;
+    if (!flushed && frameStats.renders == rendersBefore) {
+        frameStats.idleFrames++;
+    }
+
+    printFrameStats(now);
+}
+
+const DisplayFrameStats& getDisplayFrameStats() {
+    return frameStats;
+}
@@ -25,4 +25,45 @@ void displayStatus(String status);
 void displayRunningStatus(String ipAddress, String deviceID);
 void displayPortalStatus(String apName, String apIP); // FUNGSI BARU UNTUK SETUP PORTAL
 
+// === Tampilan Status Berhalaman (mode Online) ===
+// Tiap halaman dirender ke buffer off-screen hanya saat nilainya berubah;
+// pindah halaman cukup menyalin buffer ke layar.
+enum StatusPage {
+    PAGE_RINGKAS = 0,
+    PAGE_AMONIA,
+    PAGE_SABUN,
+    PAGE_TISU_AIR,
+    PAGE_JARINGAN,
+    STATUS_PAGE_COUNT
+};
+
+const unsigned long PAGE_ROTATE_MS = 5000;       // Rotasi otomatis antar halaman
+const unsigned long PAGE_MANUAL_HOLD_MS = 60000; // Setelah tombol ditekan, rotasi berhenti selama ini
+const unsigned long DISPLAY_STATS_INTERVAL_MS = 60000;
+
+// Biaya per frame (mikrodetik), dicetak ke Serial tiap DISPLAY_STATS_INTERVAL_MS
+struct DisplayFrameStats {
+    uint32_t frames;       // Panggilan displayStatusPages()
+    uint32_t idleFrames;   // Frame tanpa render dan tanpa kirim ke layar
+    uint32_t renders;      // Halaman yang digambar ulang ke buffer
+    uint32_t flushes;      // Salin buffer + kirim I2C ke SSD1306
+    uint32_t renderUsTotal;
+    uint32_t renderUsMax;
+    uint32_t flushUsTotal;
+    uint32_t flushUsMax;
+    uint32_t frameUsTotal;
+    uint32_t frameUsMax;
+};
+
+// Setter nilai: hanya menandai halaman kotor jika nilai yang TAMPIL berubah
+void statusSetIdentity(const String& ipAddress, const String& deviceID);
+void statusSetAmonia(float ppm, int skor, int cleanSamples, int txSamples);
+void statusSetSoap(long distance1, long distance2, long distance3);
+void statusSetTissueWater(int tisu1, int tisu2, int air);
+void statusSetLink(bool connected, int rssi, int pendingSamples, bool lastUplinkOk);
+
+void displayStatusPages();  // Dipanggil tiap loop; murah bila tidak ada yang berubah
+void displayNextPage();     // Tekan singkat tombol
+const DisplayFrameStats& getDisplayFrameStats();
+
 #endif
\ No newline at end of file
@@ -43,6 +43,11 @@ typedef struct {
 #include "soapSensor.h"
 #include "tissueSensor.h"
 
+// State sampling yang bertahan melewati soft reset / watchdog reset
+#include "rtcState.h"
+#include "deviceParams.h"
+#include "radioActivity.h"
+
 // PIN UNTUK MENGAKTIFKAN KEMBALI ACCESS POINT (GPIO 0)
 const int AP_BUTTON_PIN = 0; 
 
@@ -105,7 +110,17 @@ WiFiManagerParameter custom_eap_password("eap_password", "Enterprise Password",
 // === PIN & Variabel Global Utama ===
 const int ledPin = 2; // LED Indikator Status
 unsigned long lastWebUpdateTime = 0;
-const unsigned long webUpdateInterval = 1000UL; // Kirim data tiap 1 detik
+// Interval kirim data kini di deviceParams.webUpdateIntervalMs (default 1 detik)
+unsigned long lastParamsRefreshTime = 0;
+unsigned long lastMetricsReportTime = 0;
+bool paramsFetchedOnce = false;
+bool paramsAttempted = false;
+unsigned long paramsRetryInterval = PARAMS_RETRY_MIN_INTERVAL;
+bool lastUplinkOk = true;
+int waterDigitalTerakhir = -1; // Dipakai layar: tisu dan air ditampilkan bersama
+unsigned long lastLinkStatusTime = 0;
+const unsigned long LINK_STATUS_INTERVAL_MS = 1000; // RSSI cukup diperbarui sekali per detik untuk layar
+const unsigned long BUTTON_SHORT_PRESS_MS = 30;     // Di bawah ini dianggap pantulan kontak
 
 // Deklarasi fungsi-fungsi
 void kirimDataKeServer();
@@ -121,7 +136,16 @@ bool saveConfigToFS();
 void updateLocalConfigFromParameters();
 void copyParam(char* destination, size_t length, const char* source);
 void signalErrorPattern();
+String buildSensorPayload();
+String withSampleAge(const String& payload, uint32_t ageMs);
+bool postPayload(const String& endpoint, const String& apiKeyHeader, const String& payload);
+bool postSample(const String& endpoint, const String& apiKeyHeader, const String& payload);
+bool getJson(const String& endpoint, const String& apiKeyHeader, String& response);
 String buildApiEndpoint(const String& baseUrl);
+String buildDeviceEndpoint(const String& dataEndpoint, const char* suffix);
+void syncDeviceParameters();
+void kirimMetrikKeServer();
+void delaySambilSampling(unsigned long durationMs);
 bool connectToEnterpriseNetwork(const char* ssid, const char* identity, const char* password, unsigned long timeoutMs);
 
 // FUNGSI CALLBACK: Dipanggil saat konfigurasi custom field disimpan
@@ -176,6 +200,10 @@ void checkAndStartAP() {
             }
             delay(100); 
         }
+        // Tekan singkat: ganti halaman status di layar
+        if (millis() - startTime >= BUTTON_SHORT_PRESS_MS) {
+            displayNextPage();
+        }
     }
 }
 
@@ -190,11 +218,17 @@ void setup() {
 
     setupDisplay(); 
 
+    // Parameter cohort terakhir dari NVS (interval averaging dipakai oleh sensor amonia)
+    loadDeviceParams();
+
     setupAmoniaSensor();
     setupWaterSensor();
     setupSoapSensor();
     setupTissueSensor();
 
+    // Harus setelah setupAmoniaSensor() agar jendela averaging yang dipulihkan tidak ditimpa
+    bool warmResume = rtcStateRestore();
+
     spiffsMounted = SPIFFS.begin(true);
     if (spiffsMounted) {
         configLoadedFromFS = loadConfigFromFS();
@@ -218,6 +252,8 @@ void setup() {
         Serial.println("⚠️ Gagal mount SPIFFS. Konfigurasi tidak dapat dimuat.");
     }
 
+    // Event WiFi dipakai penjadwal ADC amonia untuk menghindari burst TX
+    setupRadioActivity();
     WiFi.mode(WIFI_STA);
     WiFiManager wifiManager;
     wifiManager.setTimeout(180);
@@ -256,7 +292,7 @@ void setup() {
                 Serial.println("❌ Gagal keluar dari portal konfigurasi setelah EAP gagal. Reboot.");
                 displayStatus("AP Gagal");
                 delay(2000);
-                ESP.restart();
+                restartWithSavedState();
             }
             connected = true; // jika portal berhasil, dianggap terhubung ke WiFi
         }
@@ -268,7 +304,7 @@ void setup() {
             delay(3000);
             wifiManager.resetSettings();
             delay(1000);
-            ESP.restart();
+            restartWithSavedState();
         }
         connected = true;
     }
@@ -295,11 +331,18 @@ void setup() {
     // Tampilkan Running Status Minimalis: Device ID, Status Online, dan IP
     displayRunningStatus(WiFi.localIP().toString(), custom_device_id.getValue());
 
+    if (warmResume) {
+        // Soft reset: R0 dan buffer amonia sudah dipulihkan, lewati kalibrasi ulang
+        Serial.println("♻️ Melanjutkan sampling dari state RTC.");
+        return;
+    }
+
     digitalWrite(ledPin, HIGH);
     delay(1000);
     digitalWrite(ledPin, LOW);
 
     kalibrasiAmoniaSensor(); 
+    rtcStateSave();
 }
 
 // === Loop Utama ===
@@ -310,15 +353,30 @@ void loop() {
 
     updateAmoniaBuffer(); 
 
-    if (millis() - lastWebUpdateTime >= webUpdateInterval) {
+    if (millis() - lastWebUpdateTime >= deviceParams.webUpdateIntervalMs) {
         lastWebUpdateTime = millis();
         kirimDataKeServer();
+        rtcStateSave();
+    }
+
+    // GET ini blocking sampai timeout TLS; jangan diulang tiap loop saat server menolak/mati
+    unsigned long paramsInterval = paramsFetchedOnce ? PARAMS_REFRESH_INTERVAL : paramsRetryInterval;
+    if (!paramsAttempted || millis() - lastParamsRefreshTime >= paramsInterval) {
+        syncDeviceParameters();
+    }
+
+    if (millis() - lastMetricsReportTime >= METRICS_REPORT_INTERVAL) {
+        kirimMetrikKeServer();
     }
 
     autoKalibrasiAmoniaSensor();
     
     if (WiFi.status() == WL_CONNECTED) {
         extern bool sedangKalibrasi;
+        if (millis() - lastLinkStatusTime >= LINK_STATUS_INTERVAL_MS) {
+            lastLinkStatusTime = millis();
+            statusSetLink(true, WiFi.RSSI(), rtcPendingCount(), lastUplinkOk);
+        }
         if (!sedangKalibrasi) {
             displayRunningStatus(WiFi.localIP().toString(), custom_device_id.getValue());
         }
@@ -351,90 +409,244 @@ void ensureWifiConnection() {
     }
 }
 
-void kirimDataKeServer() {
-    if (WiFi.status() != WL_CONNECTED) {
-        return;
-    }
-
+String resolveDataEndpoint() {
     String baseUrl = String(custom_api_base_url.getValue());
     baseUrl.trim();
     if (baseUrl.length() == 0) {
         baseUrl = String(defaultApiBaseUrl);
     }
+    return buildApiEndpoint(baseUrl);
+}
+
+String resolveApiKeyHeader() {
+    String apiKeyHeader = String(custom_api_key.getValue());
+    apiKeyHeader.trim();
+    return apiKeyHeader;
+}
 
-    String endpoint = buildApiEndpoint(baseUrl);
+void kirimDataKeServer() {
+    // Sampel saat WiFi putus tetap disimpan ke antrean RTC, dikirim ulang setelah tersambung
+    if (WiFi.status() != WL_CONNECTED) {
+        unsigned long capturedAt = millis();
+        rtcPushPending(buildSensorPayload(), capturedAt);
+        lastUplinkOk = false;
+        metricsRecordMissed();
+        return;
+    }
+
+    String endpoint = resolveDataEndpoint();
     if (endpoint.length() == 0) {
         Serial.println("[HTTP] Endpoint kosong atau tidak valid. Kiriman dibatalkan.");
         signalErrorPattern();
         return;
     }
 
-    String apiKeyHeader = String(custom_api_key.getValue());
-    apiKeyHeader.trim();
+    String apiKeyHeader = resolveApiKeyHeader();
+
+    // Kirim dulu sampel yang tertunda (dari sebelum soft reset / saat jaringan putus).
+    // Satu percobaan per sampel; berhenti di kegagalan pertama agar urutan tetap terjaga.
+    // ageMs memberi tahu server kapan sampel diambil, agar tidak dicatat sebagai bacaan terkini.
+    String pendingPayload;
+    uint32_t pendingAgeMs = 0;
+    while (rtcPeekPending(pendingPayload, pendingAgeMs)) {
+        if (!postSample(endpoint, apiKeyHeader, withSampleAge(pendingPayload, pendingAgeMs))) {
+            break;
+        }
+        rtcPopPending();
+    }
 
-    const int maxAttempts = 3;
+    unsigned long capturedAt = millis();
+    String jsonString = buildSensorPayload();
+
+    const int maxAttempts = deviceParams.maxSendAttempts;
     bool requestSucceeded = false;
 
     for (int attempt = 1; attempt <= maxAttempts; ++attempt) {
-        WiFiClientSecure client;
-        client.setCACert(rootCACertificate);
-        client.setTimeout(15000);
-        client.setHandshakeTimeout(15);
+        requestSucceeded = postSample(endpoint, apiKeyHeader, jsonString);
 
-        HTTPClient http;
+        if (requestSucceeded) {
+            digitalWrite(ledPin, LOW);
+            break;
+        }
 
-        if (!http.begin(client, endpoint)) {
-            Serial.printf("[HTTP] Gagal memulai koneksi ke %s (percobaan %d/%d)\n", endpoint.c_str(), attempt, maxAttempts);
-        } else {
-            http.addHeader("Content-Type", "application/json");
-            http.addHeader("Origin", "https://toilet-app.muhamadfikri.com");
-            http.addHeader("X-API-Key", apiKeyHeader);
+        signalErrorPattern();
+        if (attempt < maxAttempts) {
+            metricsRecordRetry();
+            unsigned long backoff = 1000UL << (attempt - 1); // 1s, 2s, 4s
+            delaySambilSampling(backoff);
+        }
+    }
 
-            if (apiKeyHeader.length() > 0) {
-                http.addHeader("X-API-Key", apiKeyHeader);
-            } else {
-                Serial.println("[HTTP] ⚠️ API key kosong. Permintaan kemungkinan ditolak server.");
-            }
+    lastUplinkOk = requestSucceeded;
+    if (!requestSucceeded) {
+        metricsRecordMissed();
+        rtcPushPending(jsonString, capturedAt);
+    }
+    metricsSampleHeap();
+}
 
-            StaticJsonDocument<768> doc;
-            doc["deviceID"] = custom_device_id.getValue();
-            doc["amonia"] = getAmoniaDataJson();
-            doc["waterPuddleJson"] = getWaterDataJson();
-            doc["sabun"] = getSoapDataJson();
-            doc["tisu"] = getTissueDataJson();
-            doc["espStatus"] = "active";
+// Backoff antar percobaan adalah jendela radio sepi: tetap kumpulkan sampel amonia
+void delaySambilSampling(unsigned long durationMs) {
+    unsigned long start = millis();
+    while (millis() - start < durationMs) {
+        updateAmoniaBuffer();
+        delay(20);
+    }
+}
 
-            String jsonString;
-            serializeJson(doc, jsonString);
+// Ambil parameter cohort dari server; jika gagal, tetap pakai parameter terakhir di NVS
+void syncDeviceParameters() {
+    if (WiFi.status() != WL_CONNECTED) {
+        return;
+    }
+    paramsAttempted = true;
+    lastParamsRefreshTime = millis();
 
-            int httpResponseCode = http.POST(jsonString);
+    String endpoint = buildDeviceEndpoint(resolveDataEndpoint(), "parameters");
+    if (endpoint.length() == 0) {
+        return;
+    }
 
-            if (httpResponseCode > 0) {
-                if (httpResponseCode == 200) {
-                    Serial.printf("[HTTP] POST berhasil dengan kode: %d\n", httpResponseCode);
-                    requestSucceeded = true;
-                } else {
-                    String responseBody = http.getString();
-                    Serial.printf("[HTTP] POST mengembalikan kode: %d. Respons: %s\n", httpResponseCode, responseBody.c_str());
-                }
+    String response;
+    if (!getJson(endpoint, resolveApiKeyHeader(), response)) {
+        if (!paramsFetchedOnce) {
+            paramsRetryInterval = min(paramsRetryInterval * 2, PARAMS_REFRESH_INTERVAL);
+        }
+        Serial.printf("[PARAM] Gagal mengambil parameter, memakai parameter tersimpan (coba lagi %lu s).\n",
+                      (paramsFetchedOnce ? PARAMS_REFRESH_INTERVAL : paramsRetryInterval) / 1000UL);
+        return;
+    }
+    paramsFetchedOnce = true;
+
+    if (applyDeviceParamsJson(response)) {
+        // Jendela metrik baru agar laporan tidak mencampur dua set parameter
+        metricsReset(millis());
+        lastMetricsReportTime = millis();
+    }
+}
+
+void kirimMetrikKeServer() {
+    unsigned long now = millis();
+    lastMetricsReportTime = now;
+    if (WiFi.status() != WL_CONNECTED) {
+        return;
+    }
+
+    String endpoint = buildDeviceEndpoint(resolveDataEndpoint(), "metrics");
+    if (endpoint.length() == 0) {
+        return;
+    }
+
+    // Dikirim di luar hitungan metrik uplink agar tidak mengukur dirinya sendiri
+    if (postPayload(endpoint, resolveApiKeyHeader(), buildMetricsReport(now))) {
+        metricsReset(now);
+    }
+}
+
+String buildSensorPayload() {
+    StaticJsonDocument<768> doc;
+    doc["deviceID"] = custom_device_id.getValue();
+    doc["amonia"] = getAmoniaDataJson();
+    doc["waterPuddleJson"] = getWaterDataJson();
+    doc["sabun"] = getSoapDataJson();
+    doc["tisu"] = getTissueDataJson();
+    doc["espStatus"] = "active";
+    doc["seq"] = rtcNextSequence();
+    doc["boot"] = rtcBootCount();
+
+    String jsonString;
+    serializeJson(doc, jsonString);
+    return jsonString;
+}
+
+// Sisipkan umur sampel ke objek JSON yang sudah diserialisasi (payload selalu diakhiri '}')
+String withSampleAge(const String& payload, uint32_t ageMs) {
+    int end = payload.lastIndexOf('}');
+    if (end < 0) {
+        return payload;
+    }
+    return payload.substring(0, end) + ",\"ageMs\":" + String(ageMs) + "}";
+}
+
+// postPayload untuk sampel sensor, sekaligus mencatat latensi dan ukuran ke metrik uplink
+bool postSample(const String& endpoint, const String& apiKeyHeader, const String& payload) {
+    unsigned long startedAt = millis();
+    bool success = postPayload(endpoint, apiKeyHeader, payload);
+    metricsRecordSend(success, millis() - startedAt, payload.length());
+    return success;
+}
+
+bool postPayload(const String& endpoint, const String& apiKeyHeader, const String& payload) {
+    RadioUplinkGuard radioGuard;
+    WiFiClientSecure client;
+    client.setCACert(rootCACertificate);
+    client.setTimeout(deviceParams.tlsTimeoutMs);
+    client.setHandshakeTimeout(deviceParams.tlsHandshakeTimeoutS);
+
+    HTTPClient http;
+    bool requestSucceeded = false;
+
+    if (!http.begin(client, endpoint)) {
+        Serial.printf("[HTTP] Gagal memulai koneksi ke %s\n", endpoint.c_str());
+    } else {
+        http.addHeader("Content-Type", "application/json");
+        http.addHeader("Origin", "https://toilet-app.muhamadfikri.com");
+        http.addHeader("X-API-Key", apiKeyHeader);
+
+        if (apiKeyHeader.length() > 0) {
+            http.addHeader("X-API-Key", apiKeyHeader);
+        } else {
+            Serial.println("[HTTP] ⚠️ API key kosong. Permintaan kemungkinan ditolak server.");
+        }
+
+        int httpResponseCode = http.POST(payload);
+
+        if (httpResponseCode > 0) {
+            if (httpResponseCode >= 200 && httpResponseCode < 300) {
+                Serial.printf("[HTTP] POST berhasil dengan kode: %d\n", httpResponseCode);
+                requestSucceeded = true;
             } else {
-                Serial.printf("[HTTP] POST gagal, error: %s\n", http.errorToString(httpResponseCode).c_str());
+                String responseBody = http.getString();
+                Serial.printf("[HTTP] POST mengembalikan kode: %d. Respons: %s\n", httpResponseCode, responseBody.c_str());
             }
+        } else {
+            Serial.printf("[HTTP] POST gagal, error: %s\n", http.errorToString(httpResponseCode).c_str());
         }
+    }
 
-        http.end();
+    http.end();
+    return requestSucceeded;
+}
 
-        if (requestSucceeded) {
-            digitalWrite(ledPin, LOW);
-            break;
-        }
+bool getJson(const String& endpoint, const String& apiKeyHeader, String& response) {
+    RadioUplinkGuard radioGuard;
+    WiFiClientSecure client;
+    client.setCACert(rootCACertificate);
+    client.setTimeout(deviceParams.tlsTimeoutMs);
+    client.setHandshakeTimeout(deviceParams.tlsHandshakeTimeoutS);
 
-        signalErrorPattern();
-        if (attempt < maxAttempts) {
-            unsigned long backoff = 1000UL << (attempt - 1); // 1s, 2s, 4s
-            delay(backoff);
+    HTTPClient http;
+    bool requestSucceeded = false;
+
+    if (!http.begin(client, endpoint)) {
+        Serial.printf("[HTTP] Gagal memulai koneksi ke %s\n", endpoint.c_str());
+    } else {
+        http.addHeader("Origin", "https://toilet-app.muhamadfikri.com");
+        http.addHeader("X-API-Key", apiKeyHeader);
+
+        int httpResponseCode = http.GET();
+        if (httpResponseCode == 200) {
+            response = http.getString();
+            requestSucceeded = true;
+        } else if (httpResponseCode > 0) {
+            Serial.printf("[HTTP] GET %s mengembalikan kode: %d\n", endpoint.c_str(), httpResponseCode);
+        } else {
+            Serial.printf("[HTTP] GET gagal, error: %s\n", http.errorToString(httpResponseCode).c_str());
         }
     }
+
+    http.end();
+    return requestSucceeded;
 }
 
 bool loadConfigFromFS() {
@@ -584,6 +796,18 @@ String buildApiEndpoint(const String& baseUrl) {
     return sanitized + "/data";
 }
 
+// "https://host/data" -> "https://host/device/<deviceID>/<suffix>"
+String buildDeviceEndpoint(const String& dataEndpoint, const char* suffix) {
+    String deviceId = String(custom_device_id.getValue());
+    deviceId.trim();
+    if (dataEndpoint.length() == 0 || deviceId.length() == 0) {
+        return "";
+    }
+
+    String apiRoot = dataEndpoint.substring(0, dataEndpoint.length() - strlen("/data"));
+    return apiRoot + "/device/" + deviceId + "/" + suffix;
+}
+
 bool connectToEnterpriseNetwork(const char* ssid, const char* identity, const char* password, unsigned long timeoutMs) {
     if (!ssid || strlen(ssid) == 0 || !identity || strlen(identity) == 0) {
         Serial.println("SSID atau identitas EAP kosong.");
@@ -639,10 +863,18 @@ bool connectToEnterpriseNetwork(const char* ssid, const char* identity, const ch
 String getAmoniaDataJson() {
     extern float getAveragedPPM();
 
+    // Hitung sampel sebelum getAveragedPPM() karena jendela bisa direset di sana
+    int cleanSamples = 0;
+    int txSamples = 0;
+    getAmoniaSampleCounts(cleanSamples, txSamples);
+
     float ppm_NH3 = getAveragedPPM();
+    statusSetAmonia(ppm_NH3, konversiKeLikert(ppm_NH3), cleanSamples, txSamples);
 
-    StaticJsonDocument<64> doc;
+    StaticJsonDocument<96> doc;
     doc["ppm"] = ppm_NH3;
+    doc["samples"] = cleanSamples;
+    doc["txSamples"] = txSamples;
 
     String jsonString;
     serializeJson(doc, jsonString);
@@ -652,8 +884,10 @@ String getAmoniaDataJson() {
 String getWaterDataJson() {
     extern const int waterSensorPin;
 
+    waterDigitalTerakhir = digitalRead(waterSensorPin);
+
     StaticJsonDocument<64> doc;
-    doc["digital"] = digitalRead(waterSensorPin);
+    doc["digital"] = waterDigitalTerakhir;
 
     String jsonString;
     serializeJson(doc, jsonString);
@@ -671,6 +905,7 @@ String getSoapDataJson() {
     long dist1 = (distance1 <= 1) ? -1 : distance1;
     long dist2 = (distance2 <= 1) ? -1 : distance2;
     long dist3 = (distance3 <= 1) ? -1 : distance3;
+    statusSetSoap(dist1, dist2, dist3);
 
     StaticJsonDocument<192> doc;
 
@@ -693,11 +928,16 @@ String getTissueDataJson() {
 
     StaticJsonDocument<128> doc;
 
+    int digital1 = digitalRead(tissueSensorPin1);
+    int digital2 = digitalRead(tissueSensorPin2);
+    // buildSensorPayload() membaca air sebelum tisu, jadi nilai air sudah yang terbaru
+    statusSetTissueWater(digital1, digital2, waterDigitalTerakhir);
+
     JsonObject tisu1 = doc.createNestedObject("tisu1");
-    tisu1["digital"] = digitalRead(tissueSensorPin1);
+    tisu1["digital"] = digital1;
 
     JsonObject tisu2 = doc.createNestedObject("tisu2");
-    tisu2["digital"] = digitalRead(tissueSensorPin2);
+    tisu2["digital"] = digital2;
 
     String jsonString;
     serializeJson(doc, jsonString);
@@ -0,0 +1,49 @@
+// --- radioActivity.cpp ---
+#include "radioActivity.h"
+#include <WiFi.h>
+
+// Event WiFi datang dari task lain (core 0), jadi akses dilindungi spinlock
+static portMUX_TYPE radioMux = portMUX_INITIALIZER_UNLOCKED;
+static unsigned long radioBusyUntil = 0;
+
+static void markBusyFor(unsigned long durationMs) {
+    unsigned long until = millis() + durationMs;
+    portENTER_CRITICAL(&radioMux);
+    // Bandingkan lewat selisih agar aman saat millis() overflow
+    if ((long)(until - radioBusyUntil) > 0) {
+        radioBusyUntil = until;
+    }
+    portEXIT_CRITICAL(&radioMux);
+}
+
+static void onWiFiEvent(WiFiEvent_t event) {
+    switch (event) {
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+        case ARDUINO_EVENT_WIFI_STA_START:
+        case ARDUINO_EVENT_WIFI_SCAN_DONE:
+            markBusyFor(RADIO_RECONNECT_BUSY_MS);
+            break;
+        case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            // Handshake WPA/DHCP baru saja selesai
+            markBusyFor(RADIO_QUIET_GUARD_MS);
+            break;
+        default:
+            break;
+    }
+}
+
+void setupRadioActivity() {
+    WiFi.onEvent(onWiFiEvent);
+}
+
+void radioUplinkEnd() {
+    markBusyFor(RADIO_QUIET_GUARD_MS);
+}
+
+bool radioIsQuiet() {
+    portENTER_CRITICAL(&radioMux);
+    bool quiet = (long)(millis() - radioBusyUntil) >= 0;
+    portEXIT_CRITICAL(&radioMux);
+    return quiet;
+}
@@ -0,0 +1,33 @@
+// --- radioActivity.h ---
+#ifndef RADIO_ACTIVITY_H
+#define RADIO_ACTIVITY_H
+
+#include <Arduino.h>
+
+// Setelah uplink selesai radio masih mengirim TLS close_notify, FIN/ACK dan retransmisi
+const unsigned long RADIO_QUIET_GUARD_MS = 150;
+// Scan/asosiasi ulang WiFi memancar berulang kali; anggap sibuk selama jendela ini
+const unsigned long RADIO_RECONNECT_BUSY_MS = 3000;
+
+// Daftarkan handler event WiFi (panggil sekali di setup, sebelum WiFi.begin)
+void setupRadioActivity();
+
+// Tandai jendela guard setelah uplink selesai. loop() single-thread dan uplink
+// sinkron, jadi sampler tidak pernah berjalan *selama* request; yang perlu
+// dihindari hanya ekor transmisi setelahnya.
+void radioUplinkEnd();
+
+// true jika jendela guard (uplink terakhir / event WiFi) sudah lewat
+bool radioIsQuiet();
+
+// Panggil radioUplinkEnd() saat scope berakhir; deklarasikan SEBELUM
+// WiFiClientSecure agar guard dimulai setelah socket ditutup.
+class RadioUplinkGuard {
+public:
+    RadioUplinkGuard() = default;
+    ~RadioUplinkGuard() { radioUplinkEnd(); }
+    RadioUplinkGuard(const RadioUplinkGuard&) = delete;
+    RadioUplinkGuard& operator=(const RadioUplinkGuard&) = delete;
+};
+
+#endif
@@ -0,0 +1,186 @@
+// --- rtcState.cpp ---
+#include "rtcState.h"
+#include "amoniaSensor.h"
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <cstddef>
+#include <cstring>
+
+// RTC_NOINIT_ATTR: tidak di-nol-kan oleh startup code, jadi isi bertahan
+// melewati soft reset. Setelah power-on isinya acak sehingga wajib dicek CRC.
+RTC_NOINIT_ATTR static RtcPersistentState rtcState;
+
+static bool rtcStateReady = false;
+
+static uint32_t computeCrc32(const uint8_t* data, size_t length) {
+    uint32_t crc = 0xFFFFFFFFUL;
+    for (size_t i = 0; i < length; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1UL)));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t stateCrc() {
+    return computeCrc32(reinterpret_cast<const uint8_t*>(&rtcState), offsetof(RtcPersistentState, crc));
+}
+
+static bool isStateValid() {
+    return rtcState.magic == RTC_STATE_MAGIC &&
+           rtcState.version == RTC_STATE_VERSION &&
+           rtcState.length == sizeof(RtcPersistentState) &&
+           rtcState.pendingHead < RTC_PENDING_SLOTS &&
+           rtcState.pendingCount <= RTC_PENDING_SLOTS &&
+           rtcState.crc == stateCrc();
+}
+
+static bool isWarmReset(esp_reset_reason_t reason) {
+    switch (reason) {
+        case ESP_RST_SW:
+        case ESP_RST_PANIC:
+        case ESP_RST_INT_WDT:
+        case ESP_RST_TASK_WDT:
+        case ESP_RST_WDT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void resetState() {
+    memset(&rtcState, 0, sizeof(rtcState));
+    rtcState.magic = RTC_STATE_MAGIC;
+    rtcState.version = RTC_STATE_VERSION;
+    rtcState.length = sizeof(RtcPersistentState);
+}
+
+static void sealState() {
+    rtcState.savedAtMs = millis();
+    rtcState.crc = stateCrc();
+}
+
+bool rtcStateRestore() {
+    esp_reset_reason_t reason = esp_reset_reason();
+    bool resumed = isWarmReset(reason) && isStateValid();
+
+    if (!resumed) {
+        Serial.printf("[RTC] Start dingin (reset reason %d). State RTC diinisialisasi ulang.\n", (int)reason);
+        resetState();
+    }
+
+    rtcState.bootCount++;
+    rtcStateReady = true;
+
+    if (resumed) {
+        // Waktu ambil sampel pending dipindah ke basis millis() boot ini; jeda antara
+        // segel terakhir dan reset tidak terhitung, jadi umur bisa sedikit lebih muda.
+        unsigned long now = millis();
+        for (int i = 0; i < rtcState.pendingCount; ++i) {
+            RtcPendingSample& sample = rtcState.pending[(rtcState.pendingHead + i) % RTC_PENDING_SLOTS];
+            sample.capturedAtMs = now - (rtcState.savedAtMs - sample.capturedAtMs);
+        }
+    }
+
+    if (resumed && rtcState.amonia.r0 > 0.0) {
+        unsigned long now = millis();
+        amoniaPPMBuffer = rtcState.amonia.ppmBuffer;
+        bufferCount = rtcState.amonia.bufferCount;
+        amoniaPPMBufferTx = rtcState.amonia.ppmBufferTx;
+        bufferCountTx = rtcState.amonia.bufferCountTx;
+        R0 = rtcState.amonia.r0;
+        // Aritmetika unsigned: selisih millis() tetap benar walau nilainya "mundur"
+        lastAveragingTime = now - rtcState.amonia.msSinceAveraging;
+        lastCalibrationTime = now - rtcState.amonia.msSinceCalibration;
+        sedangKalibrasi = false;
+        Serial.printf("[RTC] Resume setelah soft reset #%lu: R0=%.1f, %d+%d sampel, %d pending.\n",
+                      (unsigned long)rtcState.bootCount, R0, bufferCount, bufferCountTx, rtcState.pendingCount);
+    } else {
+        resumed = false;
+    }
+
+    sealState();
+    return resumed;
+}
+
+void rtcStateSave() {
+    if (!rtcStateReady) {
+        return;
+    }
+
+    unsigned long now = millis();
+    if (!sedangKalibrasi && R0 > 0.0) {
+        rtcState.amonia.ppmBuffer = amoniaPPMBuffer;
+        rtcState.amonia.bufferCount = bufferCount;
+        rtcState.amonia.ppmBufferTx = amoniaPPMBufferTx;
+        rtcState.amonia.bufferCountTx = bufferCountTx;
+        rtcState.amonia.msSinceAveraging = now - lastAveragingTime;
+        rtcState.amonia.r0 = R0;
+        rtcState.amonia.msSinceCalibration = now - lastCalibrationTime;
+    } else {
+        rtcState.amonia.r0 = 0.0;
+    }
+    sealState();
+}
+
+void restartWithSavedState() {
+    rtcStateSave();
+    ESP.restart();
+}
+
+uint32_t rtcNextSequence() {
+    uint32_t sequence = ++rtcState.sendSequence;
+    sealState();
+    return sequence;
+}
+
+uint32_t rtcBootCount() {
+    return rtcState.bootCount;
+}
+
+bool rtcPushPending(const String& payload, uint32_t capturedAtMs) {
+    if (payload.length() >= RTC_PENDING_PAYLOAD_SIZE) {
+        Serial.printf("[RTC] Payload %u byte melebihi slot pending %u byte; sampel dibuang.\n",
+                      (unsigned)payload.length(), (unsigned)(RTC_PENDING_PAYLOAD_SIZE - 1));
+        return false;
+    }
+
+    // Jika penuh, sampel tertua dibuang
+    if (rtcState.pendingCount == RTC_PENDING_SLOTS) {
+        rtcState.pendingHead = (rtcState.pendingHead + 1) % RTC_PENDING_SLOTS;
+        rtcState.pendingCount--;
+    }
+
+    RtcPendingSample& sample = rtcState.pending[(rtcState.pendingHead + rtcState.pendingCount) % RTC_PENDING_SLOTS];
+    sample.capturedAtMs = capturedAtMs;
+    strncpy(sample.payload, payload.c_str(), RTC_PENDING_PAYLOAD_SIZE - 1);
+    sample.payload[RTC_PENDING_PAYLOAD_SIZE - 1] = '\0';
+    rtcState.pendingCount++;
+    sealState();
+    return true;
+}
+
+bool rtcPeekPending(String& payload, uint32_t& ageMs) {
+    if (rtcState.pendingCount == 0) {
+        return false;
+    }
+    const RtcPendingSample& sample = rtcState.pending[rtcState.pendingHead];
+    payload = String(sample.payload);
+    ageMs = millis() - sample.capturedAtMs;
+    return true;
+}
+
+void rtcPopPending() {
+    if (rtcState.pendingCount == 0) {
+        return;
+    }
+    rtcState.pending[rtcState.pendingHead].payload[0] = '\0';
+    rtcState.pendingHead = (rtcState.pendingHead + 1) % RTC_PENDING_SLOTS;
+    rtcState.pendingCount--;
+    sealState();
+}
+
+int rtcPendingCount() {
+    return rtcState.pendingCount;
+}
@@ -0,0 +1,65 @@
+// --- rtcState.h ---
+#ifndef RTC_STATE_H
+#define RTC_STATE_H
+
+#include <Arduino.h>
+
+// Blok state di RTC memory: bertahan saat ESP.restart() dan reset watchdog,
+// tetapi hilang saat power-on dingin. Divalidasi dengan magic + CRC32.
+const uint32_t RTC_STATE_MAGIC = 0x544F494CUL; // "TOIL"
+const uint16_t RTC_STATE_VERSION = 3;
+
+// Antrian sampel yang gagal terkirim (dikirim ulang setelah koneksi pulih).
+// Payload sensor saat ini ~350 byte dengan device ID 40 karakter; sisakan ruang
+// untuk field tambahan agar sampel tidak ditolak diam-diam.
+const int RTC_PENDING_SLOTS = 4;
+const size_t RTC_PENDING_PAYLOAD_SIZE = 512;
+
+struct RtcAmoniaState {
+    float ppmBuffer;
+    int32_t bufferCount;
+    float ppmBufferTx;           // sampel yang terpaksa diambil saat radio aktif
+    int32_t bufferCountTx;
+    uint32_t msSinceAveraging;   // umur jendela averaging saat disimpan
+    float r0;
+    uint32_t msSinceCalibration; // umur kalibrasi saat disimpan
+};
+
+struct RtcPendingSample {
+    uint32_t capturedAtMs;       // millis() saat sampel diambil (di-rebase setelah soft reset)
+    char payload[RTC_PENDING_PAYLOAD_SIZE];
+};
+
+struct RtcPersistentState {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t length;
+    uint32_t bootCount;
+    uint32_t sendSequence;
+    uint32_t savedAtMs;          // millis() saat state terakhir disegel
+    RtcAmoniaState amonia;
+    uint8_t pendingHead;
+    uint8_t pendingCount;
+    uint8_t reserved[2];
+    RtcPendingSample pending[RTC_PENDING_SLOTS];
+    uint32_t crc;
+};
+
+// Mengembalikan true jika reset bukan power-on dan state valid; state amonia
+// (buffer, R0, umur kalibrasi) langsung dipulihkan ke variabel global.
+bool rtcStateRestore();
+// Menyimpan state amonia + counter ke RTC memory (dipanggil berkala dan sebelum restart)
+void rtcStateSave();
+// Simpan state lalu ESP.restart(); gunakan ini alih-alih ESP.restart() langsung
+void restartWithSavedState();
+
+uint32_t rtcNextSequence();
+uint32_t rtcBootCount();
+
+// capturedAtMs: millis() saat sampel diambil; ageMs dari peek = umur sampel sekarang
+bool rtcPushPending(const String& payload, uint32_t capturedAtMs);
+bool rtcPeekPending(String& payload, uint32_t& ageMs);
+void rtcPopPending();
+int rtcPendingCount();
+
+#endif
@@ -1,17 +1,19 @@
-import { FormEvent, useCallback, useEffect, useMemo, useRef, useState } from 'react';
+import { FormEvent, Profiler, useCallback, useEffect, useMemo, useRef, useState } from 'react';
 import DeviceSection from './components/DeviceSection';
 import LoginForm from './components/LoginForm';
 import { AuthenticatedUser, useAuth } from './auth/AuthContext';
 import { buildApiUrl, buildWsUrl } from './api';
+import { DecoderBatch, mergeHistoryEntries } from './decoding/decoderEngine';
+import { createSnapshotDecoder, SnapshotDecoder } from './decoding/snapshotDecoder';
+import { measure, recordTiming } from './perf';
 import {
   Config,
+  DecodedSnapshot,
   DEFAULT_SENSOR_CONFIG,
-  DeviceHistoryResponse,
   DeviceSensorConfig,
   DeviceSettingsResponse,
   HistoryDataMap,
-  LatestDataMap,
-  LatestDeviceSnapshot
+  LatestDataMap
 } from './types';
 
 type ConfigMessage = { type: 'success' | 'error'; text: string } | null;
@@ -47,8 +49,43 @@ export default function App() {
     lastMessageAt: 0,
     intervalId: null as number | null
   });
+  const decoderRef = useRef<SnapshotDecoder | null>(null);
+
+  const applyDecodedBatch = useCallback((batch: DecoderBatch) => {
+    measure('decode.apply', () => {
+      if (batch.latest) {
+        const latest = batch.latest;
+        setLatestData(prev => (batch.replaceLatest ? latest : { ...prev, ...latest }));
+      }
+      const appended = Object.entries(batch.history);
+      if (appended.length > 0) {
+        setHistoryData(prev => {
+          const next = { ...prev };
+          appended.forEach(([deviceId, entries]) => {
+            // Devices whose first page has not been fetched yet pick the rows up from that fetch.
+            const existing = next[deviceId];
+            if (existing) {
+              next[deviceId] = mergeHistoryEntries(entries, existing);
+            }
+          });
+          return next;
+        });
+      }
+    });
+  }, []);
+
+  // Declared before the WebSocket effect so the decoder exists when that effect first loads data.
+  useEffect(() => {
+    const decoder = createSnapshotDecoder(applyDecodedBatch);
+    decoderRef.current = decoder;
+    return () => {
+      decoder.terminate();
+      decoderRef.current = null;
+    };
+  }, [applyDecodedBatch]);
 
   const handleLogout = useCallback(() => {
+    decoderRef.current?.reset();
     setConfig(null);
     setLatestData({});
     setDeviceSensorSettings({});
@@ -117,8 +154,7 @@ export default function App() {
       if (!response.ok) {
         throw new Error(await response.text());
       }
-      const data: LatestDataMap = await response.json();
-      setLatestData(() => ({ ...data }));
+      decoderRef.current?.decodeLatest(await response.arrayBuffer());
     } catch (error) {
       console.error('Error fetching real-time data:', error);
     }
@@ -254,21 +290,16 @@ export default function App() {
           throw new Error(await response.text());
         }
 
-        const data: DeviceHistoryResponse = await response.json();
+        const decoder = decoderRef.current;
+        if (!decoder) {
+          return;
+        }
+        const data = await decoder.decodeHistoryPage(deviceId, await response.arrayBuffer());
 
         setHistoryData(prev => {
-          const existingEntries = prev[deviceId] ?? [];
-          const nextEntries = append
-            ? [...existingEntries, ...data.entries]
-            : (() => {
-                if (existingEntries.length === 0) {
-                  return data.entries;
-                }
-                const seenTimestamps = new Set(data.entries.map(entry => entry.timestamp));
-                const preserved = existingEntries.filter(entry => !seenTimestamps.has(entry.timestamp));
-                return [...data.entries, ...preserved];
-              })();
-          return { ...prev, [deviceId]: nextEntries };
+          const existing = prev[deviceId] ?? [];
+          const entries = append ? [...existing, ...data.entries] : mergeHistoryEntries(data.entries, existing);
+          return { ...prev, [deviceId]: entries };
         });
 
         const successMeta: DeviceHistoryMeta = {
@@ -325,6 +356,7 @@ export default function App() {
     let reconnectTimeoutId: number | null = null;
     let pollingIntervalId: number | null = null;
     let shouldReconnect = true;
+    let hasConnectedBefore = false;
 
     const stopHeartbeat = () => {
       const heartbeat = websocketHeartbeatRef.current;
@@ -388,6 +420,17 @@ export default function App() {
         stopPollingLatestData();
         websocketHeartbeatRef.current.lastMessageAt = Date.now();
         startHeartbeat();
+
+        // History appends pushed while the socket was down are lost, so resync the
+        // first page of every cached device once after each reconnect.
+        if (hasConnectedBefore) {
+          deviceIdsRef.current.forEach(deviceId => {
+            if (!historyStatusRef.current[deviceId]?.isLoading) {
+              void fetchHistoryForDevice(deviceId);
+            }
+          });
+        }
+        hasConnectedBefore = true;
       });
 
       socket.addEventListener('message', event => {
@@ -395,21 +438,10 @@ export default function App() {
           return;
         }
 
-        try {
-          websocketHeartbeatRef.current.lastMessageAt = Date.now();
-          const message = JSON.parse(event.data) as
-            | { type: 'init'; payload: LatestDataMap }
-            | { type: 'snapshot'; payload: LatestDeviceSnapshot };
-
-          if (message.type === 'init') {
-            setLatestData(() => ({ ...message.payload }));
-          } else if (message.type === 'snapshot') {
-            const snapshot = message.payload;
-            setLatestData(prev => ({ ...prev, [snapshot.deviceID]: snapshot }));
-          }
-        } catch (error) {
-          console.error('Failed to parse WebSocket message:', error);
-        }
+        websocketHeartbeatRef.current.lastMessageAt = Date.now();
+        // Parsing happens in the decoder; decoded frames come back through applyDecodedBatch.
+        const data = event.data;
+        measure('ws.message', () => decoderRef.current?.pushFrame(data));
       });
 
       socket.addEventListener('close', event => {
@@ -451,28 +483,7 @@ export default function App() {
       stopPollingLatestData();
       websocket?.close();
     };
-  }, [token, loadRealtimeData, handleUnauthorized]);
-
-  useEffect(() => {
-    if (!token || !config) {
-      return;
-    }
-
-    const refreshHistory = () => {
-      deviceIdsRef.current.forEach(deviceId => {
-        const status = historyStatusRef.current[deviceId];
-        if (status?.isLoading) {
-          return;
-        }
-        void fetchHistoryForDevice(deviceId);
-      });
-    };
-
-    refreshHistory();
-    const intervalMs = Math.max(config.historicalIntervalMinutes, 1) * 60 * 1000;
-    const intervalId = window.setInterval(refreshHistory, intervalMs);
-    return () => window.clearInterval(intervalId);
-  }, [token, config, fetchHistoryForDevice]);
+  }, [token, loadRealtimeData, handleUnauthorized, fetchHistoryForDevice]);
 
   useEffect(() => {
     if (token) {
@@ -796,43 +807,49 @@ export default function App() {
 
       <hr />
 
-      <div id="main-container">
-        {deviceIds.length === 0 ? (
-          <p className="empty-state">Belum ada data perangkat untuk ditampilkan.</p>
-        ) : (
-          deviceIds.map(deviceId => {
-            const historyMeta = historyStatus[deviceId];
-            return (
-              <DeviceSection
-                key={deviceId}
-                deviceId={deviceId}
-                data={latestData[deviceId]}
-                history={historyData[deviceId] ?? []}
-                displayName={resolveDisplayName(deviceId)}
-                sensorConfig={deviceSensorSettings[deviceId] ?? latestData[deviceId]?.sensorConfig ?? DEFAULT_SENSOR_CONFIG}
-                canRename={isSupervisor}
-                onRename={isSupervisor ? handleRenameDevice : undefined}
-                canManageSensors={isSupervisor}
-                onLoadSensorSettings={isSupervisor ? () => loadDeviceSensorSettings(deviceId) : undefined}
-                onSaveSensorSettings={
-                  isSupervisor ? config => saveDeviceSensorSettings(deviceId, config) : undefined
-                }
-                onDownloadHistory={() => handleDownloadHistory(deviceId)}
-                onLoadMoreHistory={historyMeta?.hasMore ? () => handleLoadMoreHistory(deviceId) : undefined}
-                hasMoreHistory={historyMeta?.hasMore ?? false}
-                isLoadingHistory={historyMeta?.isLoading ?? false}
-              />
-            );
-          })
-        )}
-      </div>
+      <Profiler id="devices" onRender={handleDevicesRender}>
+        <div id="main-container">
+          {deviceIds.length === 0 ? (
+            <p className="empty-state">Belum ada data perangkat untuk ditampilkan.</p>
+          ) : (
+            deviceIds.map(deviceId => {
+              const historyMeta = historyStatus[deviceId];
+              return (
+                <DeviceSection
+                  key={deviceId}
+                  deviceId={deviceId}
+                  data={latestData[deviceId]}
+                  history={historyData[deviceId] ?? []}
+                  displayName={resolveDisplayName(deviceId)}
+                  sensorConfig={deviceSensorSettings[deviceId] ?? latestData[deviceId]?.sensorConfig ?? DEFAULT_SENSOR_CONFIG}
+                  canRename={isSupervisor}
+                  onRename={isSupervisor ? handleRenameDevice : undefined}
+                  canManageSensors={isSupervisor}
+                  onLoadSensorSettings={isSupervisor ? () => loadDeviceSensorSettings(deviceId) : undefined}
+                  onSaveSensorSettings={
+                    isSupervisor ? config => saveDeviceSensorSettings(deviceId, config) : undefined
+                  }
+                  onDownloadHistory={() => handleDownloadHistory(deviceId)}
+                  onLoadMoreHistory={historyMeta?.hasMore ? () => handleLoadMoreHistory(deviceId) : undefined}
+                  hasMoreHistory={historyMeta?.hasMore ?? false}
+                  isLoadingHistory={historyMeta?.isLoading ?? false}
+                />
+              );
+            })
+          )}
+        </div>
+      </Profiler>
     </div>
   );
 }
 
+function handleDevicesRender(_id: string, _phase: string, actualDuration: number) {
+  recordTiming('react.devices', actualDuration);
+}
+
 function convertHistoryToCsv(
   deviceId: string,
-  history: HistoryDataMap[string],
+  history: DecodedSnapshot[],
   displayName?: string | null
 ): string {
   const headers = [
@@ -850,21 +867,18 @@ function convertHistoryToCsv(
 
   [...history].reverse().forEach(entry => {
     try {
-      const amonia = JSON.parse(entry.amonia);
-      const water = JSON.parse(entry.waterPuddleJson);
-      const soap = JSON.parse(entry.sabun);
-      const tissue = JSON.parse(entry.tisu);
-
-      const soapStatuses = [soap.sabun1?.status, soap.sabun2?.status, soap.sabun3?.status];
-      const soapDistances = [soap.sabun1?.distance, soap.sabun2?.distance, soap.sabun3?.distance];
-      const allSoapMissing = soapDistances.every((distance: number) => typeof distance === 'number' && distance === -1);
+      const { amonia, water, soap, tissue } = entry.sensors;
+
+      const soapStatuses = [soap.sabun1.status, soap.sabun2.status, soap.sabun3.status];
+      const soapDistances = [soap.sabun1.distance, soap.sabun2.distance, soap.sabun3.distance];
+      const allSoapMissing = soapDistances.every(distance => typeof distance === 'number' && distance === -1);
       const soapCritical = soapStatuses.includes('Habis');
       const soapLabel = allSoapMissing ? 'Data tidak ada' : soapCritical ? 'Hampir Habis' : 'Aman';
 
-      const tissueStatuses = [tissue.tisu1?.status, tissue.tisu2?.status].map((status: string) =>
+      const tissueStatuses = [tissue.tisu1.status, tissue.tisu2.status].map(status =>
         !status || status === 'N/A' ? 'Data tidak ada' : status
       );
-      const allTissueMissing = tissueStatuses.every((status: string) => status === 'Data tidak ada');
+      const allTissueMissing = tissueStatuses.every(status => status === 'Data tidak ada');
       const tissueCritical = tissueStatuses.includes('Habis');
       const tissueLabel = allTissueMissing ? 'Data tidak ada' : tissueCritical ? 'Habis' : 'Tersedia';
 
@@ -874,8 +888,8 @@ function convertHistoryToCsv(
         [
           `"${entryLabel}"`,
           `"${new Date(entry.timestamp).toLocaleString()}"`,
-          `"${Number.isFinite(amonia.ppm) ? `${amonia.ppm} ppm` : 'Data tidak ada'}"`,
-          `"${Number.isFinite(amonia.score) ? `${amonia.score}/3` : 'Data tidak ada'}"`,
+          `"${amonia.ppm !== null ? `${amonia.ppm} ppm` : 'Data tidak ada'}"`,
+          `"${amonia.score !== null ? `${amonia.score}/3` : 'Data tidak ada'}"`,
           `"${
             typeof water.digital === 'number' && water.digital !== -1
               ? `${water.status || 'Data tidak ada'} (${water.digital})`
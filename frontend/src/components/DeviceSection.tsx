@@ -1,10 +1,9 @@
 import { ReactNode, useCallback, useMemo, useState } from 'react';
 import { FaPumpSoap, FaToiletPaper, FaWater, FaWind } from 'react-icons/fa6';
 import {
-  AmmoniaSensorData,
+  DecodedSnapshot,
   DEFAULT_SENSOR_CONFIG,
   DeviceSensorConfig,
-  LatestDeviceSnapshot,
   SensorKey,
   SENSOR_KEYS,
   SoapSensorData,
@@ -14,8 +13,8 @@ import {
 
 interface DeviceSectionProps {
   deviceId: string;
-  data?: LatestDeviceSnapshot;
-  history: LatestDeviceSnapshot[];
+  data?: DecodedSnapshot;
+  history: DecodedSnapshot[];
   onDownloadHistory: () => void;
   displayName?: string | null;
   canRename?: boolean;
@@ -108,18 +107,6 @@ const SensorCard = ({
   </div>
 );
 
-const DEFAULT_AMMONIA: AmmoniaSensorData = { ppm: null, score: null, status: 'Data tidak ada' };
-const DEFAULT_WATER: WaterSensorData = { digital: -1, status: 'Data tidak ada' };
-const DEFAULT_SOAP: SoapSensorData = {
-  sabun1: { distance: -1, status: 'Data tidak ada' },
-  sabun2: { distance: -1, status: 'Data tidak ada' },
-  sabun3: { distance: -1, status: 'Data tidak ada' }
-};
-const DEFAULT_TISSUE: TissueSensorData = {
-  tisu1: { digital: -1, status: 'Data tidak ada' },
-  tisu2: { digital: -1, status: 'Data tidak ada' }
-};
-
 export default function DeviceSection({
   deviceId,
   data,
@@ -149,10 +136,7 @@ export default function DeviceSection({
     if (!data) {
       return null;
     }
-    const amonia = safeParse<AmmoniaSensorData>(data.amonia, DEFAULT_AMMONIA);
-    const water = safeParse<WaterSensorData>(data.waterPuddleJson, DEFAULT_WATER);
-    const soap = safeParse<SoapSensorData>(data.sabun, DEFAULT_SOAP);
-    const tissue = safeParse<TissueSensorData>(data.tisu, DEFAULT_TISSUE);
+    const { amonia, water, soap, tissue } = data.sensors;
 
     return {
       amonia,
@@ -483,11 +467,8 @@ export default function DeviceSection({
   );
 }
 
-function interpretSnapshot(snapshot: LatestDeviceSnapshot, sensorConfig: DeviceSensorConfig = DEFAULT_SENSOR_CONFIG) {
-  const amonia = safeParse<AmmoniaSensorData>(snapshot.amonia, DEFAULT_AMMONIA);
-  const water = safeParse<WaterSensorData>(snapshot.waterPuddleJson, DEFAULT_WATER);
-  const soap = safeParse<SoapSensorData>(snapshot.sabun, DEFAULT_SOAP);
-  const tissue = safeParse<TissueSensorData>(snapshot.tisu, DEFAULT_TISSUE);
+function interpretSnapshot(snapshot: DecodedSnapshot, sensorConfig: DeviceSensorConfig = DEFAULT_SENSOR_CONFIG) {
+  const { amonia, water, soap, tissue } = snapshot.sensors;
 
   return {
     amonia,
@@ -564,18 +545,6 @@ function hasEnabledTissue(config: DeviceSensorConfig): boolean {
   return config.tisu1 || config.tisu2;
 }
 
-function safeParse<T>(raw: string | undefined, fallback: T): T {
-  if (!raw) {
-    return fallback;
-  }
-  try {
-    return JSON.parse(raw) as T;
-  } catch (error) {
-    console.error('Failed to parse sensor payload:', error);
-    return fallback;
-  }
-}
-
 function getSafeStatus(status: string | undefined): string {
   if (!status || status === 'N/A') {
     return 'Data tidak ada';
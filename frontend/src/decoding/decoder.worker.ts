@@ -0,0 +1,11 @@
+import { DecoderEngine, DecoderRequest, DecoderResponse } from './decoderEngine';
+
+// The app is compiled against the DOM lib only, so describe the few worker globals used here.
+const workerScope = self as unknown as {
+  postMessage: (message: DecoderResponse) => void;
+  addEventListener: (type: 'message', listener: (event: MessageEvent<DecoderRequest>) => void) => void;
+};
+
+const engine = new DecoderEngine(response => workerScope.postMessage(response));
+
+workerScope.addEventListener('message', event => engine.handle(event.data));
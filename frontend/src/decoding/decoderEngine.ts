@@ -0,0 +1,274 @@
+import {
+  AmmoniaSensorData,
+  DecodedSnapshot,
+  DeviceHistoryResponse,
+  HistoryDataMap,
+  LatestDataMap,
+  LatestDeviceSnapshot,
+  RawLatestDataMap,
+  SoapSensorData,
+  SoapSensorSlot,
+  TissueSensorData,
+  TissueSensorSlot,
+  WaterSensorData
+} from '../types';
+
+export type DecoderRequest =
+  | { type: 'frame'; data: string }
+  | { type: 'latest'; body: ArrayBuffer }
+  | { type: 'history-page'; requestId: number; deviceId: string; body: ArrayBuffer }
+  | { type: 'reset' };
+
+export interface DecoderBatch {
+  type: 'batch';
+  latest: LatestDataMap | null;
+  replaceLatest: boolean;
+  /** Only the entries appended since the previous batch, newest first; merge with mergeHistoryEntries. */
+  history: HistoryDataMap;
+  frames: number;
+  decodeMs: number;
+}
+
+/** The decoded rows of one /api/history page, not the device's merged history. */
+export interface DecodedHistoryPage {
+  deviceId: string;
+  entries: DecodedSnapshot[];
+  nextCursor: string | null;
+  hasMore: boolean;
+}
+
+export type DecoderResponse =
+  | DecoderBatch
+  | ({ type: 'history-page'; requestId: number; decodeMs: number } & DecodedHistoryPage)
+  | { type: 'history-page-error'; requestId: number; message: string };
+
+type WebSocketMessage =
+  | { type: 'init'; payload: RawLatestDataMap }
+  | { type: 'snapshot'; payload: LatestDeviceSnapshot }
+  | { type: 'history'; payload: LatestDeviceSnapshot }
+  | { type: string; payload?: unknown };
+
+// Roughly one animation frame: snapshots arriving together are applied with one React update.
+const BATCH_WINDOW_MS = 16;
+
+const MISSING = 'Data tidak ada';
+const DEFAULT_SOAP_SLOT: SoapSensorSlot = { distance: -1, status: MISSING };
+const DEFAULT_TISSUE_SLOT: TissueSensorSlot = { digital: -1, status: MISSING };
+
+const textDecoder = new TextDecoder();
+
+function parseObject(raw: string | undefined): Record<string, unknown> | null {
+  if (!raw) {
+    return null;
+  }
+  try {
+    const parsed: unknown = JSON.parse(raw);
+    return typeof parsed === 'object' && parsed !== null ? (parsed as Record<string, unknown>) : null;
+  } catch (error) {
+    console.error('Failed to parse sensor payload:', error);
+    return null;
+  }
+}
+
+function numberOr(value: unknown, fallback: number): number {
+  return typeof value === 'number' && Number.isFinite(value) ? value : fallback;
+}
+
+function stringOr(value: unknown, fallback: string): string {
+  return typeof value === 'string' ? value : fallback;
+}
+
+function decodeAmmonia(raw: string | undefined): AmmoniaSensorData {
+  const parsed = parseObject(raw);
+  return {
+    ppm: typeof parsed?.ppm === 'number' && Number.isFinite(parsed.ppm) ? parsed.ppm : null,
+    score: typeof parsed?.score === 'number' && Number.isFinite(parsed.score) ? parsed.score : null,
+    status: stringOr(parsed?.status, MISSING)
+  };
+}
+
+function decodeWater(raw: string | undefined): WaterSensorData {
+  const parsed = parseObject(raw);
+  return { digital: numberOr(parsed?.digital, -1), status: stringOr(parsed?.status, MISSING) };
+}
+
+function decodeSoapSlot(value: unknown): SoapSensorSlot {
+  if (typeof value !== 'object' || value === null) {
+    return DEFAULT_SOAP_SLOT;
+  }
+  const slot = value as Record<string, unknown>;
+  return { distance: numberOr(slot.distance, -1), status: stringOr(slot.status, MISSING) };
+}
+
+function decodeTissueSlot(value: unknown): TissueSensorSlot {
+  if (typeof value !== 'object' || value === null) {
+    return DEFAULT_TISSUE_SLOT;
+  }
+  const slot = value as Record<string, unknown>;
+  return { digital: numberOr(slot.digital, -1), status: stringOr(slot.status, MISSING) };
+}
+
+function decodeSoap(raw: string | undefined): SoapSensorData {
+  const parsed = parseObject(raw);
+  return {
+    sabun1: decodeSoapSlot(parsed?.sabun1),
+    sabun2: decodeSoapSlot(parsed?.sabun2),
+    sabun3: decodeSoapSlot(parsed?.sabun3)
+  };
+}
+
+function decodeTissue(raw: string | undefined): TissueSensorData {
+  const parsed = parseObject(raw);
+  return { tisu1: decodeTissueSlot(parsed?.tisu1), tisu2: decodeTissueSlot(parsed?.tisu2) };
+}
+
+function decodeSnapshot(snapshot: LatestDeviceSnapshot): DecodedSnapshot {
+  const { amonia, waterPuddleJson, sabun, tisu, ...rest } = snapshot;
+  return {
+    ...rest,
+    sensors: {
+      amonia: decodeAmmonia(amonia),
+      water: decodeWater(waterPuddleJson),
+      soap: decodeSoap(sabun),
+      tissue: decodeTissue(tisu)
+    }
+  };
+}
+
+function decodeLatestMap(payload: RawLatestDataMap): LatestDataMap {
+  const decoded: LatestDataMap = {};
+  Object.entries(payload).forEach(([deviceId, snapshot]) => {
+    decoded[deviceId] = decodeSnapshot(snapshot);
+  });
+  return decoded;
+}
+
+export function mergeHistoryEntries(newerEntries: DecodedSnapshot[], existingEntries: DecodedSnapshot[]): DecodedSnapshot[] {
+  if (existingEntries.length === 0) {
+    return newerEntries;
+  }
+  const seenTimestamps = new Set(newerEntries.map(entry => entry.timestamp));
+  const preserved = existingEntries.filter(entry => !seenTimestamps.has(entry.timestamp));
+  return [...newerEntries, ...preserved];
+}
+
+/**
+ * Decodes WebSocket frames and API bodies. It runs inside decoder.worker.ts, or on the main thread
+ * when workers are unavailable or disabled for comparison. The merged history lives on the main
+ * thread; only new rows are posted back, so a message never structured-clones a whole device list.
+ */
+export class DecoderEngine {
+  private pendingLatest: LatestDataMap | null = null;
+  private replaceLatest = false;
+  private pendingHistory = new Map<string, DecodedSnapshot[]>();
+  private pendingFrames = 0;
+  private pendingDecodeMs = 0;
+  private flushTimer: ReturnType<typeof setTimeout> | null = null;
+
+  constructor(private readonly post: (response: DecoderResponse) => void) {}
+
+  handle(request: DecoderRequest): void {
+    switch (request.type) {
+      case 'frame':
+        this.timed(() => this.handleFrame(request.data));
+        break;
+      case 'latest':
+        this.timed(() => {
+          this.pendingLatest = decodeLatestMap(JSON.parse(textDecoder.decode(request.body)) as RawLatestDataMap);
+          this.replaceLatest = true;
+        });
+        break;
+      case 'history-page':
+        this.handleHistoryPage(request);
+        break;
+      case 'reset':
+        this.pendingLatest = null;
+        this.replaceLatest = false;
+        this.pendingHistory.clear();
+        break;
+      default:
+        break;
+    }
+  }
+
+  private timed(work: () => void): void {
+    const startedAt = performance.now();
+    try {
+      work();
+    } catch (error) {
+      console.error('Failed to decode dashboard update:', error);
+    }
+    this.pendingDecodeMs += performance.now() - startedAt;
+    this.pendingFrames += 1;
+    this.scheduleFlush();
+  }
+
+  private handleFrame(data: string): void {
+    const message = JSON.parse(data) as WebSocketMessage;
+
+    if (message.type === 'init') {
+      this.pendingLatest = decodeLatestMap(message.payload as RawLatestDataMap);
+      this.replaceLatest = true;
+    } else if (message.type === 'snapshot') {
+      const snapshot = decodeSnapshot(message.payload as LatestDeviceSnapshot);
+      this.pendingLatest = { ...(this.pendingLatest ?? {}), [snapshot.deviceID]: snapshot };
+    } else if (message.type === 'history') {
+      const entry = decodeSnapshot(message.payload as LatestDeviceSnapshot);
+      this.pendingHistory.set(entry.deviceID, [entry, ...(this.pendingHistory.get(entry.deviceID) ?? [])]);
+    }
+  }
+
+  private handleHistoryPage(request: Extract<DecoderRequest, { type: 'history-page' }>): void {
+    const startedAt = performance.now();
+    try {
+      const page = JSON.parse(textDecoder.decode(request.body)) as DeviceHistoryResponse;
+
+      this.post({
+        type: 'history-page',
+        requestId: request.requestId,
+        deviceId: request.deviceId,
+        entries: page.entries.map(decodeSnapshot),
+        nextCursor: page.nextCursor,
+        hasMore: page.hasMore,
+        decodeMs: performance.now() - startedAt
+      });
+    } catch (error) {
+      this.post({
+        type: 'history-page-error',
+        requestId: request.requestId,
+        message: error instanceof Error ? error.message : String(error)
+      });
+    }
+  }
+
+  private scheduleFlush(): void {
+    if (this.flushTimer === null) {
+      this.flushTimer = setTimeout(() => this.flush(), BATCH_WINDOW_MS);
+    }
+  }
+
+  private flush(): void {
+    this.flushTimer = null;
+
+    const history: HistoryDataMap = Object.fromEntries(this.pendingHistory);
+
+    const batch: DecoderBatch = {
+      type: 'batch',
+      latest: this.pendingLatest,
+      replaceLatest: this.replaceLatest,
+      history,
+      frames: this.pendingFrames,
+      decodeMs: this.pendingDecodeMs
+    };
+
+    this.pendingLatest = null;
+    this.replaceLatest = false;
+    this.pendingHistory.clear();
+    this.pendingFrames = 0;
+    this.pendingDecodeMs = 0;
+
+    if (batch.latest || Object.keys(history).length > 0) {
+      this.post(batch);
+    }
+  }
+}
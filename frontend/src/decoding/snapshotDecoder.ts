@@ -0,0 +1,89 @@
+import { DecodedHistoryPage, DecoderBatch, DecoderEngine, DecoderRequest, DecoderResponse } from './decoderEngine';
+import { recordTiming } from '../perf';
+
+export interface SnapshotDecoder {
+  readonly mode: 'worker' | 'main';
+  pushFrame: (data: string) => void;
+  decodeLatest: (body: ArrayBuffer) => void;
+  decodeHistoryPage: (deviceId: string, body: ArrayBuffer) => Promise<DecodedHistoryPage>;
+  reset: () => void;
+  terminate: () => void;
+}
+
+type PendingPage = { resolve: (page: DecodedHistoryPage) => void; reject: (error: Error) => void };
+
+function shouldDecodeOnMainThread(): boolean {
+  if (typeof Worker === 'undefined') {
+    return true;
+  }
+  // ?decoder=main keeps the old main-thread decoding path available for A/B timing comparisons.
+  return new URLSearchParams(window.location.search).get('decoder') === 'main';
+}
+
+/**
+ * Moves JSON parsing of WebSocket frames and API bodies off the main thread. Decoded snapshots come
+ * back in batches (at most one per ~16ms), so a burst of device updates costs one React render.
+ */
+export function createSnapshotDecoder(onBatch: (batch: DecoderBatch) => void): SnapshotDecoder {
+  const pendingPages = new Map<number, PendingPage>();
+  let nextRequestId = 1;
+
+  const handleResponse = (response: DecoderResponse) => {
+    if (response.type === 'batch') {
+      recordTiming('worker.decode', response.decodeMs);
+      onBatch(response);
+      return;
+    }
+
+    const pending = pendingPages.get(response.requestId);
+    if (!pending) {
+      return;
+    }
+    pendingPages.delete(response.requestId);
+
+    if (response.type === 'history-page') {
+      recordTiming('worker.decode', response.decodeMs);
+      const { deviceId, entries, nextCursor, hasMore } = response;
+      pending.resolve({ deviceId, entries, nextCursor, hasMore });
+    } else {
+      pending.reject(new Error(response.message));
+    }
+  };
+
+  let send: (request: DecoderRequest, transfer?: Transferable[]) => void;
+  let terminate: () => void;
+  let mode: SnapshotDecoder['mode'];
+
+  if (shouldDecodeOnMainThread()) {
+    const engine = new DecoderEngine(handleResponse);
+    send = request => engine.handle(request);
+    terminate = () => undefined;
+    mode = 'main';
+  } else {
+    const worker = new Worker(new URL('./decoder.worker.ts', import.meta.url), { type: 'module' });
+    worker.addEventListener('message', (event: MessageEvent<DecoderResponse>) => handleResponse(event.data));
+    worker.addEventListener('error', event => console.error('Snapshot decoder worker error:', event));
+    send = (request, transfer = []) => worker.postMessage(request, transfer);
+    terminate = () => worker.terminate();
+    mode = 'worker';
+  }
+
+  return {
+    mode,
+    pushFrame: data => send({ type: 'frame', data }),
+    // Bodies are transferred, not copied; callers must not touch the buffer afterwards.
+    decodeLatest: body => send({ type: 'latest', body }, [body]),
+    decodeHistoryPage: (deviceId, body) =>
+      new Promise<DecodedHistoryPage>((resolve, reject) => {
+        const requestId = nextRequestId++;
+        pendingPages.set(requestId, { resolve, reject });
+        send({ type: 'history-page', requestId, deviceId, body }, [body]);
+      }),
+    reset: () => send({ type: 'reset' }),
+    terminate: () => {
+      terminate();
+      pendingPages.forEach(pending => pending.reject(new Error('Snapshot decoder terminated')));
+      pendingPages.clear();
+    }
+  };
+}
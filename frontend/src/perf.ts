@@ -0,0 +1,88 @@
+// Opt-in main-thread timing for the dashboard. Enable with ?perf in the URL or
+// localStorage.dashboardPerf = '1', then read window.__dashboardPerf.report() in the console.
+
+interface TimingSummary {
+  count: number;
+  totalMs: number;
+  maxMs: number;
+  p50Ms: number | null;
+  p95Ms: number | null;
+}
+
+const MAX_SAMPLES_PER_LABEL = 2000;
+
+const enabled = (() => {
+  try {
+    return new URLSearchParams(window.location.search).has('perf') || window.localStorage.getItem('dashboardPerf') === '1';
+  } catch {
+    return false;
+  }
+})();
+
+const samples = new Map<string, number[]>();
+
+export function isPerfEnabled(): boolean {
+  return enabled;
+}
+
+export function recordTiming(label: string, durationMs: number): void {
+  if (!enabled) {
+    return;
+  }
+  const values = samples.get(label) ?? [];
+  if (values.length >= MAX_SAMPLES_PER_LABEL) {
+    values.shift();
+  }
+  values.push(durationMs);
+  samples.set(label, values);
+}
+
+export function measure<T>(label: string, work: () => T): T {
+  if (!enabled) {
+    return work();
+  }
+  const startedAt = performance.now();
+  try {
+    return work();
+  } finally {
+    recordTiming(label, performance.now() - startedAt);
+  }
+}
+
+function percentile(sorted: number[], fraction: number): number | null {
+  if (sorted.length === 0) {
+    return null;
+  }
+  return Number(sorted[Math.min(sorted.length - 1, Math.floor(fraction * sorted.length))].toFixed(3));
+}
+
+export function getPerfReport(): Record<string, TimingSummary> {
+  const report: Record<string, TimingSummary> = {};
+  samples.forEach((values, label) => {
+    const sorted = [...values].sort((a, b) => a - b);
+    report[label] = {
+      count: values.length,
+      totalMs: Number(values.reduce((sum, value) => sum + value, 0).toFixed(3)),
+      maxMs: Number((sorted[sorted.length - 1] ?? 0).toFixed(3)),
+      p50Ms: percentile(sorted, 0.5),
+      p95Ms: percentile(sorted, 0.95)
+    };
+  });
+  return report;
+}
+
+if (enabled) {
+  // Long tasks (>50ms) are what users feel as jank; they include work outside the labelled sections.
+  try {
+    new PerformanceObserver(list => {
+      list.getEntries().forEach(entry => recordTiming('main.longtask', entry.duration));
+    }).observe({ type: 'longtask', buffered: true });
+  } catch {
+    // Not supported outside Chromium.
+  }
+
+  (window as unknown as { __dashboardPerf: unknown }).__dashboardPerf = {
+    report: getPerfReport,
+    reset: () => samples.clear()
+  };
+}
@@ -51,8 +51,21 @@ export interface TissueSensorSlot {
   status: string;
 }
 
-export type LatestDataMap = Record<string, LatestDeviceSnapshot>;
-export type HistoryDataMap = Record<string, LatestDeviceSnapshot[]>;
+export interface DecodedSensors {
+  amonia: AmmoniaSensorData;
+  water: WaterSensorData;
+  soap: SoapSensorData;
+  tissue: TissueSensorData;
+}
+
+// Snapshot with the nested sensor JSON strings already parsed and normalized (by the decoder worker).
+export type DecodedSnapshot = Omit<LatestDeviceSnapshot, 'amonia' | 'waterPuddleJson' | 'sabun' | 'tisu'> & {
+  sensors: DecodedSensors;
+};
+
+export type LatestDataMap = Record<string, DecodedSnapshot>;
+export type HistoryDataMap = Record<string, DecodedSnapshot[]>;
+export type RawLatestDataMap = Record<string, LatestDeviceSnapshot>;
 
 export const SENSOR_KEYS = ['amonia', 'water', 'sabun1', 'sabun2', 'sabun3', 'tisu1', 'tisu2'] as const;
 export type SensorKey = (typeof SENSOR_KEYS)[number];
@@ -3,6 +3,9 @@ import react from '@vitejs/plugin-react';
 
 export default defineConfig({
   plugins: [react()],
+  worker: {
+    format: 'es'
+  },
   server: {
     host: '0.0.0.0',
     port: 5173
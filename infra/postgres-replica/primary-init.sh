@@ -0,0 +1,10 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Runs once on first start of the primary (docker-entrypoint-initdb.d).
+psql --username "${POSTGRES_USER}" --dbname "${POSTGRES_DB}" <<'SQL'
+CREATE ROLE replicator WITH REPLICATION LOGIN PASSWORD 'replicator';
+SELECT pg_create_physical_replication_slot('toilet_replica');
+SQL
+
+echo "host replication replicator all scram-sha-256" >> "${PGDATA}/pg_hba.conf"
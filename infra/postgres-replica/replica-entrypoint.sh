@@ -0,0 +1,19 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Clones the primary on first start, then runs as a hot standby. To simulate replica lag, pause
+# replay with: docker compose exec replica psql -U postgres -c 'SELECT pg_wal_replay_pause();'
+PGDATA=/var/lib/postgresql/data
+
+if [[ ! -s "${PGDATA}/PG_VERSION" ]]; then
+  until pg_basebackup --host=primary --username=replicator --pgdata="${PGDATA}" \
+      --wal-method=stream --slot=toilet_replica --write-recovery-conf --progress; do
+    echo "[replica] Waiting for primary..."
+    sleep 2
+    rm -rf "${PGDATA:?}"/*
+  done
+  chown -R postgres:postgres "${PGDATA}"
+  chmod 700 "${PGDATA}"
+fi
+
+exec gosu postgres postgres -c hot_standby=on
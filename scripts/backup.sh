@@ -1,25 +1,232 @@
 #!/usr/bin/env bash
 set -euo pipefail
 
+# Chained backups: a full run dumps every table except DeviceHistory data with a parallel
+# directory-format pg_dump and exports all history rows as id-range chunks that are
+# compressed by parallel workers. Incremental runs in the same chain repeat the (small)
+# table dump but only export history rows with an id above the previous watermark. Each
+# run uploads a manifest so scripts/restore.sh can rebuild any run in the chain in parallel.
+#
+# The watermark is the id sequence value once every transaction that could still hold a lower
+# id has finished, and the base dump and all chunks read one exported snapshot, so a row is never
+# skipped because its id was allocated before the watermark but committed after it.
+
 : "${DATABASE_URL:?DATABASE_URL environment variable must be set}"
 : "${BACKUP_BUCKET:?BACKUP_BUCKET environment variable must be set (e.g. r2://bucket-name)}"
 : "${BACKUP_RETENTION_DAYS:=30}"
+: "${BACKUP_FULL_INTERVAL_DAYS:=7}"
+: "${BACKUP_CHUNK_ROWS:=200000}"
+: "${BACKUP_JOBS:=$(nproc 2>/dev/null || echo 2)}"
+: "${BACKUP_FORCE_FULL:=false}"
+: "${BACKUP_STORAGE_CLASS:=STANDARD_IA}"
+
+export PGPASSWORD="${DATABASE_PASSWORD:-${PGPASSWORD:-}}"
+
+# Set BACKUP_S3_ENDPOINT_URL to target R2 or a local MinIO instead of AWS.
+AWS_ARGS=()
+if [[ -n "${BACKUP_S3_ENDPOINT_URL:-}" ]]; then
+  AWS_ARGS+=(--endpoint-url "${BACKUP_S3_ENDPOINT_URL}")
+fi
 
 TIMESTAMP="$(date -u +"%Y%m%dT%H%M%SZ")"
-BACKUP_BASENAME="toilet-monitoring-${TIMESTAMP}.sql.gz"
+NOW_EPOCH="$(date -u +%s)"
 BACKUP_TMP_DIR="${TMPDIR:-/tmp}/toilet-backups"
-BACKUP_PATH="${BACKUP_TMP_DIR}/${BACKUP_BASENAME}"
+RUN_DIR="${BACKUP_TMP_DIR}/${TIMESTAMP}"
+
+SNAPSHOT_HOLDER_PID=""
+
+cleanup() {
+  if [[ -n "${SNAPSHOT_HOLDER_PID}" ]]; then
+    kill "${SNAPSHOT_HOLDER_PID}" 2>/dev/null || true
+  fi
+  rm -rf "${RUN_DIR}"
+}
+
+mkdir -p "${RUN_DIR}"
+trap cleanup EXIT
+
+read_state_value() {
+  local key="$1" file="$2"
+  sed -n -E "s/^${key}=([A-Za-z0-9]+)$/\1/p" "${file}" | head -n 1
+}
+
+# --- Previous chain state ---------------------------------------------------------------
+STATE_FILE="${RUN_DIR}/previous-state.env"
+CHAIN_ID=""
+LAST_HISTORY_ID=0
+CHAIN_STARTED_AT=0
+PREVIOUS_RUN=""
+
+if aws "${AWS_ARGS[@]}" s3 cp "${BACKUP_BUCKET}/latest.env" "${STATE_FILE}" --only-show-errors 2>/dev/null; then
+  CHAIN_ID="$(read_state_value CHAIN_ID "${STATE_FILE}")"
+  LAST_HISTORY_ID="$(read_state_value LAST_HISTORY_ID "${STATE_FILE}")"
+  CHAIN_STARTED_AT="$(read_state_value CHAIN_STARTED_AT "${STATE_FILE}")"
+  PREVIOUS_RUN="$(read_state_value RUN_ID "${STATE_FILE}")"
+fi
+rm -f "${STATE_FILE}"
+
+# Ids come from a non-cached sequence and are allocated by INSERTs that already hold ROW EXCLUSIVE
+# on DeviceHistory. Waiting out the lock holders seen after reading the sequence therefore settles
+# every id up to it: each one is committed or rolled back before the snapshot below is taken.
+WATERMARK="$(psql "${DATABASE_URL}" --no-psqlrc --quiet --tuples-only --no-align --set ON_ERROR_STOP=1 <<'SQL'
+SELECT pg_get_serial_sequence('"DeviceHistory"', 'id') AS history_sequence \gset
+SELECT CASE WHEN is_called THEN last_value ELSE 0 END FROM :history_sequence;
+DO $$
+DECLARE
+  writers text[];
+  deadline timestamptz := clock_timestamp() + INTERVAL '5 minutes';
+BEGIN
+  SELECT array_agg(virtualtransaction) INTO writers
+  FROM pg_locks
+  WHERE relation = '"DeviceHistory"'::regclass AND mode = 'RowExclusiveLock' AND pid <> pg_backend_pid();
+
+  WHILE writers IS NOT NULL AND EXISTS (
+    SELECT 1 FROM pg_locks
+    WHERE relation = '"DeviceHistory"'::regclass AND virtualtransaction = ANY (writers)
+  ) LOOP
+    IF clock_timestamp() > deadline THEN
+      RAISE EXCEPTION 'DeviceHistory writers still open after 5 minutes';
+    END IF;
+    PERFORM pg_sleep(0.1);
+  END LOOP;
+END
+$$;
+SQL
+)"
+
+MODE="incremental"
+if [[ -z "${CHAIN_ID}" || -z "${LAST_HISTORY_ID}" || -z "${CHAIN_STARTED_AT}" ]]; then
+  MODE="full"
+elif [[ "${BACKUP_FORCE_FULL}" == "true" ]]; then
+  MODE="full"
+elif (( NOW_EPOCH - CHAIN_STARTED_AT >= BACKUP_FULL_INTERVAL_DAYS * 86400 )); then
+  MODE="full"
+elif (( WATERMARK < LAST_HISTORY_ID )); then
+  # The id sequence went backwards (e.g. after a restore); the chain can no longer be extended.
+  MODE="full"
+fi
+
+if [[ "${MODE}" == "full" ]]; then
+  CHAIN_ID="${TIMESTAMP}"
+  CHAIN_STARTED_AT="${NOW_EPOCH}"
+  LAST_HISTORY_ID=0
+  PREVIOUS_RUN=""
+fi
+
+echo "[backup] ${MODE} run ${TIMESTAMP} in chain ${CHAIN_ID}: DeviceHistory ids (${LAST_HISTORY_ID}, ${WATERMARK}]"
 
-mkdir -p "${BACKUP_TMP_DIR}"
+# --- Shared snapshot ------------------------------------------------------------------------
+# This REPEATABLE READ transaction stays open until every export below is done; pg_dump and the
+# chunk COPYs all attach to its snapshot.
+coproc SNAPSHOT_HOLDER {
+  psql "${DATABASE_URL}" --no-psqlrc --quiet --tuples-only --no-align --set ON_ERROR_STOP=1
+}
+SNAPSHOT_HOLDER_PID="${SNAPSHOT_HOLDER_PID:-}"
+printf '%s\n' 'BEGIN ISOLATION LEVEL REPEATABLE READ;' 'SELECT pg_export_snapshot();' >&"${SNAPSHOT_HOLDER[1]}"
+if ! read -r -t 60 SNAPSHOT_ID <&"${SNAPSHOT_HOLDER[0]}" || [[ -z "${SNAPSHOT_ID}" ]]; then
+  echo "[backup] Could not export a database snapshot" >&2
+  exit 1
+fi
 
-PGPASSWORD="${DATABASE_PASSWORD:-}" pg_dump --dbname="${DATABASE_URL}" --format=plain --no-owner --no-privileges \
-  | gzip > "${BACKUP_PATH}"
+# --- Small tables + schema ----------------------------------------------------------------
+pg_dump --dbname="${DATABASE_URL}" --format=directory --jobs="${BACKUP_JOBS}" --compress=6 \
+  --no-owner --no-privileges --exclude-table-data='"DeviceHistory"' \
+  --snapshot="${SNAPSHOT_ID}" --file="${RUN_DIR}/base"
 
-aws s3 cp "${BACKUP_PATH}" "${BACKUP_BUCKET}/${BACKUP_BASENAME}" --storage-class STANDARD_IA
+# --- DeviceHistory chunks ----------------------------------------------------------------
+mkdir -p "${RUN_DIR}/history"
 
-rm -f "${BACKUP_PATH}"
+dump_history_chunk() {
+  set -euo pipefail
+  local lower="$1" upper="$2"
+  psql "${DATABASE_URL}" --no-psqlrc --quiet --set ON_ERROR_STOP=1 \
+    --command 'BEGIN ISOLATION LEVEL REPEATABLE READ' \
+    --command "SET TRANSACTION SNAPSHOT '${SNAPSHOT_ID}'" \
+    --command \
+    "COPY (SELECT \"id\", \"deviceId\", \"displayName\", \"amonia\", \"waterPuddleJson\", \"sabun\", \"tisu\",
+                  \"timestamp\", \"espStatus\", \"lastActive\", \"createdAt\"
+           FROM \"DeviceHistory\" WHERE \"id\" > ${lower} AND \"id\" <= ${upper} ORDER BY \"id\") TO STDOUT" \
+    --command 'COMMIT' \
+    | gzip > "${RUN_DIR}/history/${lower}-${upper}.copy.gz"
+}
+export -f dump_history_chunk
+export DATABASE_URL RUN_DIR SNAPSHOT_ID
 
-aws s3 ls "${BACKUP_BUCKET}" | awk '{print $4}' \
+CHUNK_COUNT=0
+if (( WATERMARK > LAST_HISTORY_ID )); then
+  for (( lower = LAST_HISTORY_ID; lower < WATERMARK; lower += BACKUP_CHUNK_ROWS )); do
+    upper=$(( lower + BACKUP_CHUNK_ROWS ))
+    (( upper > WATERMARK )) && upper="${WATERMARK}"
+    printf '%s %s\n' "${lower}" "${upper}"
+    CHUNK_COUNT=$(( CHUNK_COUNT + 1 ))
+  done > "${RUN_DIR}/chunks.txt"
+
+  xargs --arg-file="${RUN_DIR}/chunks.txt" --max-args=2 --max-procs="${BACKUP_JOBS}" \
+    bash -c 'dump_history_chunk "$1" "$2"' _
+fi
+rm -f "${RUN_DIR}/chunks.txt"
+
+printf 'COMMIT;\n' >&"${SNAPSHOT_HOLDER[1]}"
+eval "exec ${SNAPSHOT_HOLDER[1]}>&-"
+wait "${SNAPSHOT_HOLDER_PID}"
+SNAPSHOT_HOLDER_PID=""
+
+# --- Manifest -----------------------------------------------------------------------------
+(cd "${RUN_DIR}" && find base history -type f -print0 | sort -z | xargs -0 sha256sum > SHA256SUMS)
+
+cat > "${RUN_DIR}/manifest.json" <<EOF
+{
+  "runId": "${TIMESTAMP}",
+  "chainId": "${CHAIN_ID}",
+  "mode": "${MODE}",
+  "previousRunId": $( [[ -n "${PREVIOUS_RUN}" ]] && printf '"%s"' "${PREVIOUS_RUN}" || printf 'null' ),
+  "createdAt": "$(date -u -d "@${NOW_EPOCH}" +"%Y-%m-%dT%H:%M:%SZ")",
+  "history": {
+    "fromIdExclusive": ${LAST_HISTORY_ID},
+    "toIdInclusive": ${WATERMARK},
+    "chunkRows": ${BACKUP_CHUNK_ROWS},
+    "chunks": ${CHUNK_COUNT}
+  },
+  "base": { "format": "pg_dump directory", "excludesTableData": ["DeviceHistory"] },
+  "checksums": "SHA256SUMS"
+}
+EOF
+
+RUN_PREFIX="${BACKUP_BUCKET}/chains/${CHAIN_ID}/${TIMESTAMP}"
+aws "${AWS_ARGS[@]}" s3 cp "${RUN_DIR}" "${RUN_PREFIX}/" --recursive --only-show-errors \
+  --storage-class "${BACKUP_STORAGE_CLASS}"
+
+# The state pointer is written last so a failed upload never becomes the base of the next run.
+cat > "${RUN_DIR}/latest.env" <<EOF
+CHAIN_ID=${CHAIN_ID}
+RUN_ID=${TIMESTAMP}
+CHAIN_STARTED_AT=${CHAIN_STARTED_AT}
+LAST_HISTORY_ID=${WATERMARK}
+EOF
+aws "${AWS_ARGS[@]}" s3 cp "${RUN_DIR}/latest.env" "${BACKUP_BUCKET}/latest.env" --only-show-errors
+
+echo "[backup] Uploaded ${MODE} run to ${RUN_PREFIX} (${CHUNK_COUNT} history chunks)"
+
+# --- Retention ----------------------------------------------------------------------------
+# A chain is only removed once its newest possible run (start + full interval) is past the
+# retention window, so every restore point younger than BACKUP_RETENTION_DAYS stays complete.
+cutoff=$(( NOW_EPOCH - (BACKUP_RETENTION_DAYS + BACKUP_FULL_INTERVAL_DAYS) * 86400 ))
+aws "${AWS_ARGS[@]}" s3 ls "${BACKUP_BUCKET}/chains/" | awk '$1 == "PRE" {print $2}' | tr -d '/' \
+  | while read -r chain; do
+      if [[ "${chain}" == "${CHAIN_ID}" ]]; then
+        continue
+      fi
+      chain_date=$(echo "${chain}" | sed -E 's/^([0-9]{8})T([0-9]{2})([0-9]{2})([0-9]{2})Z$/\1 \2:\3:\4/')
+      if [[ "${chain_date}" != "${chain}" ]]; then
+        chain_ts=$(date -u -d "${chain_date}" +%s)
+        if [[ "${chain_ts}" -lt "${cutoff}" ]]; then
+          aws "${AWS_ARGS[@]}" s3 rm "${BACKUP_BUCKET}/chains/${chain}/" --recursive --only-show-errors
+        fi
+      fi
+    done
+
+# Legacy single-file dumps from before chained backups.
+aws "${AWS_ARGS[@]}" s3 ls "${BACKUP_BUCKET}/" | awk '{print $4}' \
   | grep '^toilet-monitoring-' \
   | while read -r object; do
       backup_date=$(echo "${object}" | sed -E 's/^toilet-monitoring-([0-9]{8})T([0-9]{6})Z.sql.gz$/\1T\2Z/')
@@ -27,7 +234,7 @@ aws s3 ls "${BACKUP_BUCKET}" | awk '{print $4}' \
         backup_ts=$(date -u -d "${backup_date}" +%s)
         cutoff=$(date -u -d "-${BACKUP_RETENTION_DAYS} days" +%s)
         if [ "${backup_ts}" -lt "${cutoff}" ]; then
-          aws s3 rm "${BACKUP_BUCKET}/${object}"
+          aws "${AWS_ARGS[@]}" s3 rm "${BACKUP_BUCKET}/${object}"
         fi
       fi
-    done
+    done || true
@@ -0,0 +1,117 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Restores a chained backup written by scripts/backup.sh into an empty database.
+#
+# Usage: restore.sh <target-database-url> [run-id]
+#   run-id  YYYYMMDDTHHMMSSZ restore point; defaults to the newest uploaded run. The newest
+#           run at or before this time is chosen, then its chain is replayed up to it.
+
+TARGET_DATABASE_URL="${1:?Usage: restore.sh <target-database-url> [run-id]}"
+TARGET_RUN="${2:-}"
+
+: "${BACKUP_BUCKET:?BACKUP_BUCKET environment variable must be set (e.g. r2://bucket-name)}"
+: "${BACKUP_JOBS:=$(nproc 2>/dev/null || echo 2)}"
+
+AWS_ARGS=()
+if [[ -n "${BACKUP_S3_ENDPOINT_URL:-}" ]]; then
+  AWS_ARGS+=(--endpoint-url "${BACKUP_S3_ENDPOINT_URL}")
+fi
+
+RESTORE_DIR="${TMPDIR:-/tmp}/toilet-restore-$$"
+mkdir -p "${RESTORE_DIR}"
+trap 'rm -rf "${RESTORE_DIR}"' EXIT
+
+list_prefixes() {
+  aws "${AWS_ARGS[@]}" s3 ls "$1" | awk '$1 == "PRE" {print $2}' | tr -d '/' | sort
+}
+
+# --- Pick the restore point -----------------------------------------------------------------
+CHAIN_ID=""
+RUN_ID=""
+for chain in $(list_prefixes "${BACKUP_BUCKET}/chains/"); do
+  if [[ -n "${TARGET_RUN}" && "${chain}" > "${TARGET_RUN}" ]]; then
+    break
+  fi
+  for run in $(list_prefixes "${BACKUP_BUCKET}/chains/${chain}/"); do
+    if [[ -n "${TARGET_RUN}" && "${run}" > "${TARGET_RUN}" ]]; then
+      break
+    fi
+    CHAIN_ID="${chain}"
+    RUN_ID="${run}"
+  done
+done
+
+if [[ -z "${RUN_ID}" ]]; then
+  echo "[restore] No backup run found at or before ${TARGET_RUN:-now}" >&2
+  exit 1
+fi
+
+echo "[restore] Restoring run ${RUN_ID} from chain ${CHAIN_ID}"
+
+# --- Download and verify every run of the chain up to the restore point ----------------------
+RUNS=()
+for run in $(list_prefixes "${BACKUP_BUCKET}/chains/${CHAIN_ID}/"); do
+  if [[ "${run}" > "${RUN_ID}" ]]; then
+    break
+  fi
+  RUNS+=("${run}")
+  if [[ "${run}" == "${RUN_ID}" ]]; then
+    aws "${AWS_ARGS[@]}" s3 cp "${BACKUP_BUCKET}/chains/${CHAIN_ID}/${run}/" "${RESTORE_DIR}/${run}/" \
+      --recursive --only-show-errors
+  else
+    # Earlier runs only contribute their history chunks; the base comes from the restore point.
+    aws "${AWS_ARGS[@]}" s3 cp "${BACKUP_BUCKET}/chains/${CHAIN_ID}/${run}/" "${RESTORE_DIR}/${run}/" \
+      --recursive --only-show-errors --exclude 'base/*'
+    sed -i '/  base\//d' "${RESTORE_DIR}/${run}/SHA256SUMS"
+  fi
+  (cd "${RESTORE_DIR}/${run}" && sha256sum --check --quiet SHA256SUMS)
+done
+
+if [[ "${RUNS[0]}" != "${CHAIN_ID}" ]]; then
+  echo "[restore] Chain ${CHAIN_ID} is missing its full run; refusing to restore a partial history" >&2
+  exit 1
+fi
+
+# --- Schema and small tables ----------------------------------------------------------------
+pg_restore --dbname="${TARGET_DATABASE_URL}" --jobs="${BACKUP_JOBS}" --no-owner --no-privileges \
+  --exit-on-error "${RESTORE_DIR}/${RUN_ID}/base"
+
+# --- DeviceHistory chunks -------------------------------------------------------------------
+# The retention trigger would run a per-row delete during the bulk load; it is disabled here
+# and applied once below relative to the restore point instead.
+psql "${TARGET_DATABASE_URL}" --no-psqlrc --quiet --set ON_ERROR_STOP=1 \
+  --command 'ALTER TABLE "DeviceHistory" DISABLE TRIGGER device_history_retention'
+
+load_history_chunk() {
+  set -euo pipefail
+  gunzip --stdout "$1" | psql "${TARGET_DATABASE_URL}" --no-psqlrc --quiet --set ON_ERROR_STOP=1 --command \
+    'COPY "DeviceHistory" ("id", "deviceId", "displayName", "amonia", "waterPuddleJson", "sabun", "tisu",
+                           "timestamp", "espStatus", "lastActive", "createdAt") FROM STDIN'
+}
+export -f load_history_chunk
+export TARGET_DATABASE_URL
+
+find "${RESTORE_DIR}" -path '*/history/*.copy.gz' -type f -print0 \
+  | xargs --null --no-run-if-empty --max-args=1 --max-procs="${BACKUP_JOBS}" bash -c 'load_history_chunk "$1"' _
+
+RESTORE_POINT="$(echo "${RUN_ID}" | sed -E 's/^([0-9]{4})([0-9]{2})([0-9]{2})T([0-9]{2})([0-9]{2})([0-9]{2})Z$/\1-\2-\3 \4:\5:\6+00/')"
+
+# Chunks are append-only exports, so rows pruned by retention between runs are pruned again
+# here with the same rules as prune_device_history(), evaluated at the restore point.
+psql "${TARGET_DATABASE_URL}" --no-psqlrc --quiet --set ON_ERROR_STOP=1 <<SQL
+DELETE FROM "DeviceHistory"
+WHERE "timestamp" < TIMESTAMPTZ '${RESTORE_POINT}' - INTERVAL '30 days'
+   OR "id" IN (
+     SELECT "id" FROM (
+       SELECT "id", ROW_NUMBER() OVER (PARTITION BY "deviceId" ORDER BY "timestamp" DESC) AS position
+       FROM "DeviceHistory"
+     ) ranked
+     WHERE ranked.position > 1000
+   );
+ALTER TABLE "DeviceHistory" ENABLE TRIGGER device_history_retention;
+SELECT setval(pg_get_serial_sequence('"DeviceHistory"', 'id'), GREATEST((SELECT MAX("id") FROM "DeviceHistory"), 1));
+ANALYZE "DeviceHistory";
+SQL
+
+echo "[restore] Restored ${#RUNS[@]} run(s) of chain ${CHAIN_ID} up to ${RUN_ID}"